@@ -73,6 +73,11 @@ namespace Glitter
 		return version;
 	}
 
+	Endianness BinaryReader::getEndianness() const
+	{
+		return endianness;
+	}
+
 	size_t BinaryReader::getRootNodeAddress() const
 	{
 		return rootNodeAddress;
@@ -189,11 +194,10 @@ namespace Glitter
 		if (file)
 		{
 			fread(&data, sizeof(uint16_t), 1, file);
-			half_float::half halfValue(data);
 			if (endianness == Endianness::BIG)
 				swapEndianness(data);
 
-			target = halfValue.operator float();
+			target = half_float::detail::half2float<float>(data);
 		}
 
 		return target;
@@ -53,6 +53,7 @@ namespace Glitter
 		size_t getCurrentAddress() const;
 		size_t getRootNodeAddress() const;
 		int getVersion() const;
+		Endianness getEndianness() const;
 		bool valid() const;
 		void close() const;
 		void changeEndianness(Endianness en);
@@ -12,6 +12,7 @@ namespace Glitter
 	constexpr uint32_t		VERTEX_FORMAT_MAX_ENTRIES			= 256;
 
 	constexpr uint32_t		BONE_AFFECT_LIMIT					= 4;
+	constexpr uint32_t		VERTEX_CACHE_SIZE					= 16;
 
 	constexpr uint32_t		MODEL_SUBMESH_SLOT_SOLID			= 0;
 	constexpr uint32_t		MODEL_SUBMESH_SLOT_TRANSPARENT		= 1;
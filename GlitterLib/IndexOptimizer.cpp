@@ -0,0 +1,681 @@
+#include "IndexOptimizer.h"
+#include "Submesh.h"
+#include "../tristripper/tri_stripper.h"
+#include <algorithm>
+#include <numeric>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <stdio.h>
+
+namespace Glitter
+{
+	// a vertex is in the FIFO cache if it was one of the last cacheSize misses
+	struct FifoCache
+	{
+		std::vector<unsigned int> stamps;
+		unsigned int time;
+		unsigned int size;
+
+		FifoCache(size_t vertexCount, unsigned int cacheSize) :
+			stamps(vertexCount, 0), time{ cacheSize + 1 }, size{ cacheSize }
+		{
+		}
+
+		bool fetch(unsigned int index)
+		{
+			if (time - stamps[index] <= size)
+				return false;
+
+			stamps[index] = time++;
+			return true;
+		}
+
+		void flush()
+		{
+			time += size + 1;
+		}
+	};
+
+	size_t IndexOptimizer::getVertexCount(const std::vector<Polygon>& triangles)
+	{
+		size_t count = 0;
+		for (const Polygon& poly : triangles)
+			count = std::max(count, (size_t)std::max(poly.a, std::max(poly.b, poly.c)) + 1);
+
+		return count;
+	}
+
+	std::vector<unsigned int> IndexOptimizer::optimizeVertexCache(std::vector<Polygon>& triangles, unsigned int cacheSize)
+	{
+		const unsigned int none = 0xFFFFFFFF;
+		std::vector<unsigned int> clusters;
+		size_t triangleCount = triangles.size();
+		size_t vertexCount = getVertexCount(triangles);
+		if (!triangleCount)
+			return clusters;
+
+		// triangles using each vertex, packed into one array
+		std::vector<unsigned int> liveTriangles(vertexCount, 0);
+		for (const Polygon& poly : triangles)
+		{
+			++liveTriangles[poly.a];
+			++liveTriangles[poly.b];
+			++liveTriangles[poly.c];
+		}
+
+		std::vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0);
+		for (size_t v = 0; v < vertexCount; ++v)
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+
+		std::vector<unsigned int> adjacency(adjacencyOffsets[vertexCount]);
+		std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			adjacency[fill[triangles[t].a]++] = t;
+			adjacency[fill[triangles[t].b]++] = t;
+			adjacency[fill[triangles[t].c]++] = t;
+		}
+
+		std::vector<unsigned int> stamps(vertexCount, 0);
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<unsigned int> deadEnds;
+		std::vector<unsigned int> candidates;
+		std::vector<Polygon> result;
+		result.reserve(triangleCount);
+
+		unsigned int time = cacheSize + 1;
+		size_t cursor = 0;
+		unsigned int fanning = none;
+
+		while (true)
+		{
+			if (fanning == none)
+			{
+				// dead end: go back to a recently used vertex, or the next unfinished one in input order
+				while (deadEnds.size() && fanning == none)
+				{
+					unsigned int v = deadEnds.back();
+					deadEnds.pop_back();
+					if (liveTriangles[v])
+						fanning = v;
+				}
+
+				for (; fanning == none && cursor < vertexCount; ++cursor)
+				{
+					if (liveTriangles[cursor])
+						fanning = cursor;
+				}
+
+				if (fanning == none)
+					break;
+
+				clusters.push_back(result.size());
+			}
+
+			// emit the whole remaining fan around the vertex
+			candidates.clear();
+			for (unsigned int i = adjacencyOffsets[fanning]; i < adjacencyOffsets[fanning + 1]; ++i)
+			{
+				unsigned int t = adjacency[i];
+				if (emitted[t])
+					continue;
+
+				emitted[t] = true;
+				const Polygon& poly = triangles[t];
+				result.push_back(poly);
+
+				for (unsigned int v : { poly.a, poly.b, poly.c })
+				{
+					deadEnds.push_back(v);
+					candidates.push_back(v);
+					--liveTriangles[v];
+
+					if (time - stamps[v] > cacheSize)
+						stamps[v] = time++;
+				}
+			}
+
+			// prefer the oldest vertex that would still be cached after its own fan is emitted
+			fanning = none;
+			int bestPriority = -1;
+			for (unsigned int v : candidates)
+			{
+				if (!liveTriangles[v])
+					continue;
+
+				int priority = 0;
+				if (time - stamps[v] + 2 * liveTriangles[v] <= cacheSize)
+					priority = time - stamps[v];
+
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					fanning = v;
+				}
+			}
+		}
+
+		triangles.swap(result);
+		return clusters;
+	}
+
+	std::vector<unsigned int> IndexOptimizer::splitClusters(const std::vector<Polygon>& triangles, const std::vector<unsigned int>& hardClusters,
+		size_t vertexCount, unsigned int cacheSize, float threshold)
+	{
+		float limit = analyzeVertexCache(triangles, cacheSize).acmr * threshold;
+
+		std::vector<unsigned int> clusters;
+		FifoCache cache(vertexCount, cacheSize);
+		for (size_t c = 0; c < hardClusters.size(); ++c)
+		{
+			size_t start = hardClusters[c];
+			size_t end = c + 1 < hardClusters.size() ? hardClusters[c + 1] : triangles.size();
+			size_t misses = 0;
+
+			clusters.push_back(start);
+			cache.flush();
+
+			for (size_t t = start; t < end; ++t)
+			{
+				misses += cache.fetch(triangles[t].a);
+				misses += cache.fetch(triangles[t].b);
+				misses += cache.fetch(triangles[t].c);
+
+				// once a cluster is as cache friendly as the whole mesh it can be moved around on its own
+				if (t + 1 < end && misses <= limit * (t + 1 - start))
+				{
+					clusters.push_back(t + 1);
+					start = t + 1;
+					misses = 0;
+					cache.flush();
+				}
+			}
+		}
+
+		return clusters;
+	}
+
+	size_t IndexOptimizer::optimizeOverdraw(std::vector<Polygon>& triangles, const std::vector<Vertex>& vertices,
+		const std::vector<unsigned int>& hardClusters, unsigned int cacheSize, float threshold)
+	{
+		size_t vertexCount = getVertexCount(triangles);
+		if (triangles.empty() || hardClusters.empty() || vertexCount > vertices.size())
+			return hardClusters.size();
+
+		std::vector<unsigned int> clusters = splitClusters(triangles, hardClusters, vertexCount, cacheSize, threshold);
+		size_t clusterCount = clusters.size();
+
+		std::vector<Vector3> positions;
+		positions.reserve(vertices.size());
+		for (const Vertex& vertex : vertices)
+			positions.push_back(vertex.getPosition());
+
+		// area weighted centroids and summed normals, per cluster and for the whole mesh
+		std::vector<Vector3> clusterCentroids(clusterCount);
+		std::vector<Vector3> clusterNormals(clusterCount);
+		std::vector<float> clusterAreas(clusterCount, 0.0f);
+		Vector3 meshCentroid;
+		float meshArea = 0.0f;
+
+		for (size_t c = 0; c < clusterCount; ++c)
+		{
+			size_t end = c + 1 < clusterCount ? clusters[c + 1] : triangles.size();
+			for (size_t t = clusters[c]; t < end; ++t)
+			{
+				Vector3& p0 = positions[triangles[t].a];
+				Vector3& p1 = positions[triangles[t].b];
+				Vector3& p2 = positions[triangles[t].c];
+
+				Vector3 normal = (p1 - p0).crossProduct(p2 - p0);
+				float area = normal.length();
+				Vector3 centroid = (p0 + p1 + p2) * (area / 3.0f);
+
+				clusterCentroids[c] += centroid;
+				clusterNormals[c] += normal;
+				clusterAreas[c] += area;
+				meshCentroid += centroid;
+				meshArea += area;
+			}
+		}
+
+		if (meshArea > 0.0f)
+			meshCentroid *= 1.0f / meshArea;
+
+		// clusters facing away from the mesh center are likely to occlude the rest, so they are drawn first
+		std::vector<float> occlusion(clusterCount, 0.0f);
+		for (size_t c = 0; c < clusterCount; ++c)
+		{
+			if (clusterAreas[c] <= 0.0f || clusterNormals[c].normalise() <= 0.0f)
+				continue;
+
+			Vector3 centroid = clusterCentroids[c] / clusterAreas[c];
+			occlusion[c] = (centroid - meshCentroid).dotProduct(clusterNormals[c]);
+		}
+
+		std::vector<unsigned int> order(clusterCount);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&occlusion](unsigned int a, unsigned int b) { return occlusion[a] > occlusion[b]; });
+
+		std::vector<Polygon> result;
+		result.reserve(triangles.size());
+		for (unsigned int c : order)
+		{
+			size_t end = c + 1 < clusterCount ? clusters[c + 1] : triangles.size();
+			result.insert(result.end(), triangles.begin() + clusters[c], triangles.begin() + end);
+		}
+
+		triangles.swap(result);
+		return clusterCount;
+	}
+
+	// vertex index that continues the strip with the triangle, or 0xFFFFFFFF;
+	// the next strip triangle is (p, q, new) on odd strip positions and (new, q, p) on even ones
+	static unsigned int getStripContinuation(const Polygon& poly, unsigned int p, unsigned int q, bool odd)
+	{
+		unsigned int r[3] = { poly.a, poly.b, poly.c };
+		for (int i = 0; i < 3; ++i)
+		{
+			unsigned int r0 = r[i], r1 = r[(i + 1) % 3], r2 = r[(i + 2) % 3];
+			if (odd && r0 == p && r1 == q)
+				return r2;
+			if (!odd && r1 == q && r2 == p)
+				return r0;
+		}
+
+		return 0xFFFFFFFF;
+	}
+
+	static bool isDegenerate(const Polygon& poly)
+	{
+		return poly.a == poly.b || poly.b == poly.c || poly.a == poly.c;
+	}
+
+	static uint64_t getEdgeKey(unsigned int from, unsigned int to)
+	{
+		return ((uint64_t)from << 32) | to;
+	}
+
+	size_t IndexOptimizer::buildStrips(const std::vector<Polygon>& triangles, std::vector<unsigned short>& strips, size_t window)
+	{
+		// directed edges of every triangle, sorted so the triangle across an edge can be looked up by its reverse
+		std::vector<std::pair<uint64_t, unsigned int>> edges;
+		edges.reserve(triangles.size() * 3);
+		for (size_t t = 0; t < triangles.size(); ++t)
+		{
+			const Polygon& poly = triangles[t];
+			if (isDegenerate(poly))
+				continue;
+
+			edges.push_back({ getEdgeKey(poly.a, poly.b), (unsigned int)t });
+			edges.push_back({ getEdgeKey(poly.b, poly.c), (unsigned int)t });
+			edges.push_back({ getEdgeKey(poly.c, poly.a), (unsigned int)t });
+		}
+
+		std::sort(edges.begin(), edges.end());
+
+		// 0 is unused, stamps above that mark triangles taken by a strip or by the walk being measured
+		std::vector<unsigned int> used(triangles.size(), 0);
+		const unsigned int taken = 1;
+		unsigned int stamp = taken;
+
+		// strips only take triangles this close to their head, so they stay in the cache order instead of running across the mesh
+		size_t end = 0;
+
+		// first triangle not marked with stamp or taken that holds the directed edge, or SIZE_MAX
+		auto findTriangle = [&](unsigned int from, unsigned int to)
+		{
+			uint64_t key = getEdgeKey(from, to);
+			auto it = std::lower_bound(edges.begin(), edges.end(), std::make_pair(key, 0u));
+			for (; it != edges.end() && it->first == key; ++it)
+			{
+				if (it->second < end && used[it->second] != taken && used[it->second] != stamp)
+					return (size_t)it->second;
+			}
+
+			return SIZE_MAX;
+		};
+
+		// follows the adjacency from a strip ending in (p, q) for at most limit triangles, marking them with mark,
+		// and returns how many it added
+		auto walk = [&](unsigned int p, unsigned int q, bool odd, unsigned int mark, std::vector<unsigned short>* out, size_t limit)
+		{
+			size_t length = 0;
+			while (length < limit)
+			{
+				// odd positions continue with (p, q, new), even ones with (new, q, p)
+				size_t next = odd ? findTriangle(p, q) : findTriangle(q, p);
+				if (next == SIZE_MAX)
+					break;
+
+				unsigned int index = getStripContinuation(triangles[next], p, q, odd);
+				used[next] = mark;
+				if (out)
+					out->push_back((unsigned short)index);
+
+				p = q;
+				q = index;
+				odd = !odd;
+				++length;
+			}
+
+			return length;
+		};
+
+		strips.clear();
+		strips.reserve(triangles.size() * 2);
+
+		std::vector<unsigned short> backward;
+		size_t stripCount = 0;
+		for (size_t head = 0; head < triangles.size(); ++head)
+		{
+			// strips grow from the earliest triangle left in cache order, Submesh::convertStrips drops degenerates anyway
+			if (used[head] == taken || isDegenerate(triangles[head]))
+				continue;
+
+			end = std::min(triangles.size(), head + window);
+			const Polygon& poly = triangles[head];
+			unsigned int r[3] = { poly.a, poly.b, poly.c };
+			used[head] = taken;
+
+			// the strip through it reads (.., r2, r1, r0, ..) and continues across (r1, r0) forwards and (r1, r2) backwards;
+			// the backward part is walked as the reversed strip (r0, r1, r2, ..) and has to be even to keep the winding
+			int rotation = 0;
+			size_t before = 0;
+			size_t longest = 0;
+			for (int i = 0; i < 3; ++i)
+			{
+				++stamp;
+				size_t back = walk(r[(i + 1) % 3], r[(i + 2) % 3], false, stamp, nullptr, SIZE_MAX) & ~(size_t)1;
+				size_t length = back + walk(r[(i + 1) % 3], r[i], true, stamp, nullptr, SIZE_MAX);
+				if (length > longest)
+				{
+					longest = length;
+					before = back;
+					rotation = i;
+				}
+			}
+
+			// stamps are only compared for equality with the current one, restart before they wrap
+			if (stamp > 0xFFFFFFF0)
+			{
+				for (unsigned int& mark : used)
+					mark = mark == taken ? taken : 0;
+
+				stamp = taken;
+			}
+
+			++stamp;
+			unsigned int r0 = r[rotation], r1 = r[(rotation + 1) % 3], r2 = r[(rotation + 2) % 3];
+			backward.clear();
+			walk(r1, r2, false, taken, &backward, before);
+
+			if (strips.size())
+				strips.push_back(0xFFFF);
+
+			strips.insert(strips.end(), backward.rbegin(), backward.rend());
+			strips.push_back((unsigned short)r2);
+			strips.push_back((unsigned short)r1);
+			strips.push_back((unsigned short)r0);
+			walk(r1, r0, true, taken, &strips, SIZE_MAX);
+			++stripCount;
+		}
+
+		return stripCount;
+	}
+
+	size_t IndexOptimizer::buildLegacyStrips(const std::vector<Polygon>& triangles, std::vector<unsigned short>& strips)
+	{
+		// tri_stripper keeps the winding it is given, Submesh::convertStrips reads strips the other way round
+		triangle_stripper::indices triIndices;
+		triIndices.reserve(triangles.size() * 3);
+		for (const Polygon& poly : triangles)
+		{
+			triIndices.push_back(poly.c);
+			triIndices.push_back(poly.b);
+			triIndices.push_back(poly.a);
+		}
+
+		triangle_stripper::tri_stripper stripper(triIndices);
+		stripper.SetCacheSize(0);
+		stripper.SetBackwardSearch(false);
+		triangle_stripper::primitive_vector primitives;
+		stripper.Strip(&primitives);
+
+		strips.clear();
+		size_t stripCount = 0;
+		for (const triangle_stripper::primitive_group& group : primitives)
+		{
+			size_t step = group.Type == triangle_stripper::TRIANGLE_STRIP ? group.Indices.size() : 3;
+			for (size_t j = 0; j + step <= group.Indices.size(); j += step)
+			{
+				if (strips.size())
+					strips.push_back(0xFFFF);
+
+				for (size_t k = j; k < j + step; ++k)
+					strips.push_back((unsigned short)group.Indices[k]);
+
+				++stripCount;
+			}
+		}
+
+		return stripCount;
+	}
+
+	size_t IndexOptimizer::buildTriangleList(const std::vector<Polygon>& triangles, std::vector<unsigned short>& strips)
+	{
+		strips.clear();
+		strips.reserve(triangles.size() * 4);
+
+		size_t stripCount = 0;
+		for (const Polygon& poly : triangles)
+		{
+			if (isDegenerate(poly))
+				continue;
+
+			if (strips.size())
+				strips.push_back(0xFFFF);
+
+			// a lone strip triangle (c, b, a) keeps the winding of (a, b, c)
+			strips.push_back((unsigned short)poly.c);
+			strips.push_back((unsigned short)poly.b);
+			strips.push_back((unsigned short)poly.a);
+			++stripCount;
+		}
+
+		return stripCount;
+	}
+
+	size_t IndexOptimizer::stripify(const std::vector<Polygon>& triangles, std::vector<unsigned short>& strips,
+		const IndexOptimizerOptions& options, StripEncoding* encoding)
+	{
+		StripEncoding chosen = StripEncoding::Triangles;
+		size_t stripCount = buildTriangleList(triangles, strips);
+
+		if (options.strips)
+		{
+			// the list replays the cache order exactly, strips are only kept while they don't give that up
+			std::vector<unsigned short> candidate;
+			size_t candidateCount = buildStrips(triangles, candidate, std::max(options.cacheSize / 2, 1u));
+
+			size_t listMisses = analyzeVertexCache(strips, options.cacheSize).misses;
+			size_t stripMisses = analyzeVertexCache(candidate, options.cacheSize).misses;
+			if (candidate.size() < strips.size() && stripMisses <= listMisses * options.stripThreshold)
+			{
+				strips.swap(candidate);
+				stripCount = candidateCount;
+				chosen = StripEncoding::Strips;
+			}
+		}
+
+		if (encoding)
+			*encoding = chosen;
+
+		return stripCount;
+	}
+
+	VertexCacheStats IndexOptimizer::analyzeVertexCache(const std::vector<Polygon>& triangles, unsigned int cacheSize)
+	{
+		VertexCacheStats stats;
+		size_t vertexCount = getVertexCount(triangles);
+		FifoCache cache(vertexCount, cacheSize);
+		std::vector<bool> referenced(vertexCount, false);
+
+		for (const Polygon& poly : triangles)
+		{
+			for (unsigned int v : { poly.a, poly.b, poly.c })
+			{
+				stats.misses += cache.fetch(v);
+				if (!referenced[v])
+				{
+					referenced[v] = true;
+					++stats.vertices;
+				}
+			}
+		}
+
+		stats.triangles = triangles.size();
+		stats.acmr = stats.triangles ? (float)stats.misses / stats.triangles : 0.0f;
+		stats.atvr = stats.vertices ? (float)stats.misses / stats.vertices : 0.0f;
+		return stats;
+	}
+
+	VertexCacheStats IndexOptimizer::analyzeVertexCache(const std::vector<unsigned short>& strips, unsigned int cacheSize)
+	{
+		VertexCacheStats stats;
+		size_t vertexCount = 0;
+		for (unsigned short index : strips)
+		{
+			if (index != 0xFFFF)
+				vertexCount = std::max(vertexCount, (size_t)index + 1);
+		}
+
+		// restart indices don't flush the cache
+		FifoCache cache(vertexCount, cacheSize);
+		std::vector<bool> referenced(vertexCount, false);
+		for (unsigned short index : strips)
+		{
+			if (index == 0xFFFF)
+				continue;
+
+			stats.misses += cache.fetch(index);
+			if (!referenced[index])
+			{
+				referenced[index] = true;
+				++stats.vertices;
+			}
+		}
+
+		stats.triangles = Submesh::convertStrips(strips.data(), strips.size(), nullptr);
+		stats.acmr = stats.triangles ? (float)stats.misses / stats.triangles : 0.0f;
+		stats.atvr = stats.vertices ? (float)stats.misses / stats.vertices : 0.0f;
+		return stats;
+	}
+
+	IndexBuildReport IndexOptimizer::optimize(std::vector<Polygon>& triangles, const std::vector<Vertex>& vertices,
+		std::vector<unsigned short>& strips, const IndexOptimizerOptions& options)
+	{
+		using Clock = std::chrono::high_resolution_clock;
+
+		IndexBuildReport report;
+		report.cacheSize = options.cacheSize;
+		report.input = analyzeVertexCache(triangles, options.cacheSize);
+
+		auto t0 = Clock::now();
+		std::vector<unsigned int> clusters = optimizeVertexCache(triangles, options.cacheSize);
+		report.clusterCount = clusters.size();
+
+		auto t1 = Clock::now();
+		if (options.overdraw)
+			report.clusterCount = optimizeOverdraw(triangles, vertices, clusters, options.cacheSize, options.overdrawThreshold);
+
+		auto t2 = Clock::now();
+		report.stripCount = stripify(triangles, strips, options, &report.encoding);
+
+		auto t3 = Clock::now();
+		report.cacheTime = std::chrono::duration<double, std::milli>(t1 - t0).count();
+		report.overdrawTime = std::chrono::duration<double, std::milli>(t2 - t1).count();
+		report.stripTime = std::chrono::duration<double, std::milli>(t3 - t2).count();
+
+		report.indexCount = strips.size();
+		report.optimized = analyzeVertexCache(triangles, options.cacheSize);
+		report.output = analyzeVertexCache(strips, options.cacheSize);
+		return report;
+	}
+
+	std::string IndexOptimizer::formatReport(const IndexBuildReport& report)
+	{
+		const char* encodingNames[] = { "strips", "triangles" };
+
+		char msg[512];
+		int length = snprintf(msg, sizeof(msg),
+			"%zu triangles, %zu vertices, cache %u: ACMR %.3f -> %.3f (cache order %.3f), ATVR %.3f -> %.3f (cache order %.3f), "
+			"%zu indices in %zu %s, %zu clusters; reorder %.3fms, overdraw %.3fms, strips %.3fms",
+			report.input.triangles, report.input.vertices, report.cacheSize,
+			report.input.acmr, report.output.acmr, report.optimized.acmr,
+			report.input.atvr, report.output.atvr, report.optimized.atvr,
+			report.indexCount, report.stripCount, encodingNames[(int)report.encoding], report.clusterCount,
+			report.cacheTime, report.overdrawTime, report.stripTime);
+
+		if (report.legacyTime > 0.0 && length > 0 && length < (int)sizeof(msg))
+		{
+			snprintf(msg + length, sizeof(msg) - length, "; tri_stripper %.3fms, ACMR %.3f, ATVR %.3f, %zu indices",
+				report.legacyTime, report.legacy.acmr, report.legacy.atvr, report.legacyIndexCount);
+		}
+
+		return msg;
+	}
+
+	std::vector<IndexBuildReport> IndexOptimizer::benchmark()
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		const unsigned int sizes[] = { 32, 64, 128, 250 };
+
+		std::vector<IndexBuildReport> reports;
+		std::mt19937 engine(1234);
+
+		for (unsigned int size : sizes)
+		{
+			// bumpy grid with its triangles shuffled, like an export that ignored cache order
+			unsigned int width = size + 1;
+			std::vector<Vertex> vertices(width * width);
+			for (unsigned int z = 0; z < width; ++z)
+			{
+				for (unsigned int x = 0; x < width; ++x)
+					vertices[z * width + x].setPosition(Vector3((float)x, std::sin(x * 0.3f) * std::cos(z * 0.3f) * 4.0f, (float)z));
+			}
+
+			std::vector<Polygon> triangles;
+			triangles.reserve(size * size * 2);
+			for (unsigned int z = 0; z < size; ++z)
+			{
+				for (unsigned int x = 0; x < size; ++x)
+				{
+					unsigned int i = z * width + x;
+					triangles.push_back(Polygon{ i, i + 1, i + width });
+					triangles.push_back(Polygon{ i + 1, i + width + 1, i + width });
+				}
+			}
+
+			std::shuffle(triangles.begin(), triangles.end(), engine);
+
+			// the stripper Submesh::build used before
+			auto t0 = Clock::now();
+			std::vector<unsigned short> legacyStrips;
+			buildLegacyStrips(triangles, legacyStrips);
+
+			auto t1 = Clock::now();
+
+			std::vector<unsigned short> strips;
+			IndexBuildReport report = optimize(triangles, vertices, strips);
+			report.legacyTime = std::chrono::duration<double, std::milli>(t1 - t0).count();
+			report.legacy = analyzeVertexCache(legacyStrips, report.cacheSize);
+			report.legacyIndexCount = legacyStrips.size();
+			reports.push_back(report);
+		}
+
+		return reports;
+	}
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <vector>
+#include <string>
+#include "Constants.h"
+
+namespace Glitter
+{
+	struct Polygon;
+	class Vertex;
+
+	struct VertexCacheStats
+	{
+		size_t triangles = 0;
+		size_t vertices = 0;
+		size_t misses = 0;
+
+		// average cache miss ratio, misses per triangle
+		float acmr = 0.0f;
+
+		// average transform to vertex ratio, misses per referenced vertex
+		float atvr = 0.0f;
+	};
+
+	enum class StripEncoding
+	{
+		// restart separated strips walked over triangle adjacency close to the cache order
+		Strips,
+
+		// one strip per triangle, kept when strips would cost more cache misses than the threshold allows
+		Triangles
+	};
+
+	struct IndexOptimizerOptions
+	{
+		unsigned int cacheSize = VERTEX_CACHE_SIZE;
+		bool overdraw = true;
+		float overdrawThreshold = 1.05f;
+		bool strips = true;
+		float stripThreshold = 1.05f;
+	};
+
+	struct IndexBuildReport
+	{
+		unsigned int cacheSize = 0;
+		VertexCacheStats input;
+		VertexCacheStats optimized;
+
+		// measured on the emitted indices
+		VertexCacheStats output;
+		size_t indexCount = 0;
+		size_t stripCount = 0;
+		size_t clusterCount = 0;
+		StripEncoding encoding = StripEncoding::Triangles;
+		double cacheTime = 0.0;
+		double overdrawTime = 0.0;
+		double stripTime = 0.0;
+
+		// only filled by the benchmark, for the tri_stripper path this replaced
+		VertexCacheStats legacy;
+		size_t legacyIndexCount = 0;
+		double legacyTime = 0.0;
+	};
+
+	/// <summary>
+	/// Index buffer optimization for exported submeshes.
+	/// Triangles are reordered for the post-transform vertex cache (Tipsify), clusters of that order are sorted
+	/// to reduce overdraw, and the result is joined into strips by walking triangle adjacency in that order.
+	/// Strips are separated by the 0xFFFF primitive restart index; when they miss the cache more often than
+	/// the triangle order does, one strip per triangle is written instead.
+	/// </summary>
+	class IndexOptimizer
+	{
+	private:
+		static size_t getVertexCount(const std::vector<Polygon>& triangles);
+		static std::vector<unsigned int> splitClusters(const std::vector<Polygon>& triangles, const std::vector<unsigned int>& hardClusters,
+			size_t vertexCount, unsigned int cacheSize, float threshold);
+
+		static size_t buildStrips(const std::vector<Polygon>& triangles, std::vector<unsigned short>& strips, size_t window);
+		static size_t buildLegacyStrips(const std::vector<Polygon>& triangles, std::vector<unsigned short>& strips);
+		static size_t buildTriangleList(const std::vector<Polygon>& triangles, std::vector<unsigned short>& strips);
+
+	public:
+		static std::vector<unsigned int> optimizeVertexCache(std::vector<Polygon>& triangles, unsigned int cacheSize);
+		static size_t optimizeOverdraw(std::vector<Polygon>& triangles, const std::vector<Vertex>& vertices,
+			const std::vector<unsigned int>& clusters, unsigned int cacheSize, float threshold);
+		static size_t stripify(const std::vector<Polygon>& triangles, std::vector<unsigned short>& strips,
+			const IndexOptimizerOptions& options = IndexOptimizerOptions(), StripEncoding* encoding = nullptr);
+
+		static VertexCacheStats analyzeVertexCache(const std::vector<Polygon>& triangles, unsigned int cacheSize);
+		static VertexCacheStats analyzeVertexCache(const std::vector<unsigned short>& strips, unsigned int cacheSize);
+
+		static IndexBuildReport optimize(std::vector<Polygon>& triangles, const std::vector<Vertex>& vertices,
+			std::vector<unsigned short>& strips, const IndexOptimizerOptions& options = IndexOptimizerOptions());
+
+		static std::string formatReport(const IndexBuildReport& report);
+		static std::vector<IndexBuildReport> benchmark();
+	};
+}
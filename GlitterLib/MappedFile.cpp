@@ -0,0 +1,87 @@
+#include "MappedFile.h"
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Glitter
+{
+	MappedFile::MappedFile(const std::string& filename) :
+		data{ nullptr }, size{ 0 }
+	{
+#ifdef _WIN32
+		mapping = NULL;
+
+		// allow the file to be replaced by a newer cache while it's mapped
+		file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			return;
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+			return;
+
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping == NULL)
+			return;
+
+		data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (data)
+			size = (size_t)fileSize.QuadPart;
+#else
+		descriptor = open(filename.c_str(), O_RDONLY);
+		if (descriptor < 0)
+			return;
+
+		struct stat info;
+		if (fstat(descriptor, &info) != 0 || info.st_size == 0)
+			return;
+
+		void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+		if (view == MAP_FAILED)
+			return;
+
+		data = (const unsigned char*)view;
+		size = (size_t)info.st_size;
+#endif
+	}
+
+	MappedFile::~MappedFile()
+	{
+#ifdef _WIN32
+		if (data)
+			UnmapViewOfFile(data);
+
+		if (mapping != NULL)
+			CloseHandle(mapping);
+
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+#else
+		if (data)
+			munmap((void*)data, size);
+
+		if (descriptor >= 0)
+			close(descriptor);
+#endif
+	}
+
+	bool MappedFile::valid() const
+	{
+		return data != nullptr;
+	}
+
+	const unsigned char* MappedFile::getData() const
+	{
+		return data;
+	}
+
+	size_t MappedFile::getSize() const
+	{
+		return size;
+	}
+}
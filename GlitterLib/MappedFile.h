@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+
+namespace Glitter
+{
+	/// <summary>
+	/// Read only view of a whole file mapped into memory. Pages are loaded by the OS when first touched.
+	/// </summary>
+	class MappedFile
+	{
+	private:
+		const unsigned char* data;
+		size_t size;
+#ifdef _WIN32
+		void* file;
+		void* mapping;
+#else
+		int descriptor;
+#endif
+
+	public:
+		MappedFile(const std::string& filename);
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		~MappedFile();
+
+		bool valid() const;
+		const unsigned char* getData() const;
+		size_t getSize() const;
+	};
+}
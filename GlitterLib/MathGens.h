@@ -77,11 +77,11 @@ namespace Glitter
 			Vector2(float x_p, float y_p) : x(x_p), y(y_p) {
 			}
 
-			inline bool operator == (const Vector2& vector) {
+			inline bool operator == (const Vector2& vector) const {
 	            return (x == vector.x && y == vector.y);
 			}
 
-			inline bool operator != (const Vector2& vector) {
+			inline bool operator != (const Vector2& vector) const {
 	            return (x != vector.x || y != vector.y);
 			}
 			
@@ -114,11 +114,11 @@ namespace Glitter
 			Vector3(float x_p, float y_p, float z_p) : x(x_p), y(y_p), z(z_p) {
 			}
 
-			inline bool operator == (const Vector3& vector) {
+			inline bool operator == (const Vector3& vector) const {
 	            return ( x == vector.x && y == vector.y && z == vector.z );
 			}
 
-			inline bool operator != (const Vector3& vector) {
+			inline bool operator != (const Vector3& vector) const {
 	            return (x != vector.x || y != vector.y || z != vector.z);
 			}
 
@@ -476,11 +476,11 @@ namespace Glitter
 				Color::Color((unsigned char *) &col);
 			}
 
-			inline bool operator == (const Color& color) {
+			inline bool operator == (const Color& color) const {
 	            return ((r == color.r) && (g == color.g) && (b == color.b) && (a == color.a));
 			}
 
-			inline bool operator != (const Color& color) {
+			inline bool operator != (const Color& color) const {
 	            return ((r != color.r) || (g != color.g) || (b != color.b) || (a != color.a));
 			}
 
@@ -17,10 +17,10 @@ namespace Glitter
 	{
 		for (int slot = 0; slot < MODEL_SUBMESH_SLOTS; ++slot)
 		{
-			for (int sub = 0; sub < submeshes[slot].size(); ++sub)
+			for (int sub = 0; sub < clone->submeshes[slot].size(); ++sub)
 			{
 				Submesh* submesh = new Submesh(clone->submeshes[slot][sub], transform, uv2Left, uv2Right, uv2Top, uv2Bottom);
-				submeshes->push_back(submesh);
+				submeshes[slot].push_back(submesh);
 			}
 		}
 
@@ -104,22 +104,16 @@ namespace Glitter
 		return submeshes;
 	}
 
-	std::list<Vertex*> Mesh::getVertexList()
+	size_t Mesh::getVertexCount() const
 	{
-		std::list<Vertex*> submeshVertices;
-		std::list<Vertex*> meshVertices;
-
+		size_t count = 0;
 		for (int slot = 0; slot < MODEL_SUBMESH_SLOTS; ++slot)
 		{
-			for (std::vector<Submesh*>::iterator it = submeshes[slot].begin(); it != submeshes[slot].end(); ++it)
-			{
-				submeshVertices = (*it)->getVerticesList();
-				for (std::list<Vertex*>::iterator it = submeshVertices.begin(); it != submeshVertices.end(); ++it)
-					meshVertices.push_back(*it);
-			}
+			for (const Submesh* submesh : submeshes[slot])
+				count += submesh->getVerticesSize();
 		}
 
-		return meshVertices;
+		return count;
 	}
 
 	std::list<unsigned int> Mesh::getFacesList()
@@ -137,7 +131,7 @@ namespace Glitter
 				for (std::list<unsigned int>::iterator it = submeshFaces.begin(); it != submeshFaces.end(); ++it)
 					facesList.push_back((*it) + faceOffset);
 
-				faceOffset += (*it)->getVerticesList().size();
+				faceOffset += (*it)->getVerticesSize();
 			}
 		}
 
@@ -195,7 +189,7 @@ namespace Glitter
 					materialIndex++;
 				}
 
-				size_t faces_size = (*it)->getFacesList().size();
+				size_t faces_size = (*it)->getTriangles().size() * 3;
 				for (size_t i = 0; i < faces_size; i++)
 					materialMappings.push_back(materialMap);
 			}
@@ -255,7 +249,7 @@ namespace Glitter
 		return total;
 	}
 
-	void Mesh::read(BinaryReader* reader)
+	void Mesh::read(BinaryReader* reader, bool deferDecode)
 	{
 		size_t headerAddress = reader->getCurrentAddress();
 		for (int slot = 0; slot < MODEL_SUBMESH_SLOTS; ++slot)
@@ -300,8 +294,10 @@ namespace Glitter
 					reader->gotoAddress(submeshAddress);
 
 					Submesh* submesh = new Submesh();
-					submesh->read(reader);
-					submesh->buildAABB();
+					submesh->readBuffers(reader);
+					if (!deferDecode)
+						submesh->decode();
+
 					submeshes[slot].push_back(submesh);
 				}
 			}
@@ -316,8 +312,10 @@ namespace Glitter
 					reader->gotoAddress(submeshAddress);
 
 					Submesh* submesh = new Submesh();
-					submesh->read(reader);
-					submesh->buildAABB();
+					submesh->readBuffers(reader);
+					if (!deferDecode)
+						submesh->decode();
+
 					submeshes[slot].push_back(submesh);
 
 					if (submesh->getBoneTable().size() > 25)
@@ -25,7 +25,7 @@ namespace Glitter
 		std::string getExtra();
 		bool hasExtra();
 		AABB getAABB();
-		std::list<Vertex*> getVertexList();
+		size_t getVertexCount() const;
 		std::list<unsigned int> getFacesList();
 		std::list<std::string> getMaterialNames();
 		std::vector<unsigned int> getMaterialMappings(std::list<std::string> &materialNames);
@@ -37,7 +37,7 @@ namespace Glitter
 		void buildAABB();
 		void addSubmesh(Submesh* submesh, int slot);
 		void removeSubmesh(Submesh* submesh, int slot);
-		void read(BinaryReader* reader);
+		void read(BinaryReader* reader, bool deferDecode = false);
 		void write(BinaryWriter* writer);
 	};
 }
\ No newline at end of file
@@ -1,8 +1,106 @@
 #include "Model.h"
 #include "File.h"
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
 
 namespace Glitter
 {
+	bool Model::parallelDecoding = true;
+
+	// models with fewer vertices than this decode faster on the calling thread than it takes to wake the pool
+	constexpr size_t parallelDecodeVertices = 16384;
+
+	// decoding threads, started with the first large model and kept for every load after it
+	class DecodePool
+	{
+	private:
+		std::vector<std::thread> workers;
+		std::mutex runMutex;
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::condition_variable finished;
+		std::function<void()> job;
+		size_t generation;
+		size_t running;
+		bool stopping;
+
+		DecodePool() : generation{ 0 }, running{ 0 }, stopping{ false }
+		{
+			size_t count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+			workers.reserve(count);
+			for (size_t i = 0; i < count; ++i)
+				workers.emplace_back(&DecodePool::workerLoop, this);
+		}
+
+		void workerLoop()
+		{
+			size_t seen = 0;
+			std::unique_lock<std::mutex> lock(mutex);
+			while (true)
+			{
+				wake.wait(lock, [this, seen]() { return stopping || generation != seen; });
+				if (stopping)
+					return;
+
+				seen = generation;
+				std::function<void()> work = job;
+				lock.unlock();
+				work();
+				lock.lock();
+
+				if (--running == 0)
+					finished.notify_one();
+			}
+		}
+
+	public:
+		~DecodePool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+
+			wake.notify_all();
+			for (std::thread& worker : workers)
+				worker.join();
+		}
+
+		static DecodePool& get()
+		{
+			static DecodePool pool;
+			return pool;
+		}
+
+		size_t getThreadCount() const
+		{
+			return workers.size() + 1;
+		}
+
+		// runs work on every pool thread and the caller, and returns once all of them are done
+		void run(const std::function<void()>& work)
+		{
+			std::lock_guard<std::mutex> runLock(runMutex);
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				job = work;
+				running = workers.size();
+				++generation;
+			}
+
+			wake.notify_all();
+			work();
+
+			std::unique_lock<std::mutex> lock(mutex);
+			finished.wait(lock, [this]() { return running == 0; });
+			job = nullptr;
+		}
+	};
+
 	Model::Model()
 	{
 		meshes.clear();
@@ -10,9 +108,11 @@ namespace Glitter
 		name = "";
 		filename = "";
 		terrainMode = false;
+		keepStrips = true;
 	}
 
-	Model::Model(std::string filename)
+	Model::Model(std::string filename, bool keepStrips) :
+		keepStrips{ keepStrips }
 	{
 		BinaryReader reader(filename, Endianness::BIG);
 		this->filename = filename;
@@ -36,6 +136,7 @@ namespace Glitter
 			return;
 
 		this->terrainMode = terrainMode;
+		keepStrips = true;
 		if (terrainMode)
 		{
 			printf("terrain mode not supported. aborting.\n");
@@ -57,9 +158,16 @@ namespace Glitter
 		bones.clear();
 	}
 
-	void Model::getTotalData(std::list<Vertex*> &vertexList, std::list<unsigned int> &facesList, std::list<std::string> &materialNames, std::vector<unsigned int> &materialMappings)
+	void Model::getTotalData(std::vector<Vertex> &vertexList, std::list<unsigned int> &facesList, std::list<std::string> &materialNames, std::vector<unsigned int> &materialMappings)
 	{
-		vertexList = getVertexList();
+		vertexList.clear();
+		vertexList.reserve(getVertexCount());
+		for (Mesh* mesh : meshes)
+		{
+			for (Submesh* submesh : mesh->getSubmeshes())
+				vertexList.insert(vertexList.end(), submesh->getVertices().begin(), submesh->getVertices().end());
+		}
+
 		facesList = getFacesList();
 		materialNames = getMaterialNames();
 		materialMappings = getMaterialMappings(materialNames);
@@ -89,11 +197,57 @@ namespace Glitter
 			size_t meshAddress = reader->readAddress();
 			reader->gotoAddress(meshAddress);
 
+			// only pull the raw buffers off the file here; decoding doesn't need the reader
 			Mesh* mesh = new Mesh();
-			mesh->read(reader);
-			mesh->buildAABB();
+			mesh->read(reader, true);
 			meshes.push_back(mesh);
 		}
+
+		decodeSubmeshes();
+
+		for (Mesh* mesh : meshes)
+			mesh->buildAABB();
+	}
+
+	void Model::decodeSubmeshes()
+	{
+		std::vector<Submesh*> submeshes;
+		size_t vertexCount = 0;
+		for (Mesh* mesh : meshes)
+		{
+			std::vector<Submesh*> meshSubmeshes = mesh->getSubmeshes();
+			submeshes.insert(submeshes.end(), meshSubmeshes.begin(), meshSubmeshes.end());
+
+			for (Submesh* submesh : meshSubmeshes)
+				vertexCount += submesh->getVerticesSize();
+		}
+
+		if (!parallelDecoding || submeshes.size() < 2 || vertexCount < parallelDecodeVertices || DecodePool::get().getThreadCount() < 2)
+		{
+			for (Submesh* submesh : submeshes)
+				submesh->decode(keepStrips);
+
+			return;
+		}
+
+		// every submesh decodes in place, so the result doesn't depend on which thread picked it up
+		std::atomic<size_t> next{ 0 };
+		bool keep = keepStrips;
+		DecodePool::get().run([&submeshes, &next, keep]()
+		{
+			for (size_t i = next++; i < submeshes.size(); i = next++)
+				submeshes[i]->decode(keep);
+		});
+	}
+
+	void Model::setParallelDecoding(bool enabled)
+	{
+		parallelDecoding = enabled;
+	}
+
+	bool Model::isParallelDecoding()
+	{
+		return parallelDecoding;
 	}
 
 	void Model::readSkeleton(BinaryReader* reader)
@@ -209,19 +363,13 @@ namespace Glitter
 		writer->gotoEnd();
 	}
 
-	std::list<Vertex*> Model::getVertexList()
+	size_t Model::getVertexCount() const
 	{
-		std::list<Vertex*> allVertices;
-		std::list<Vertex*> meshVertices;
+		size_t count = 0;
+		for (const Mesh* mesh : meshes)
+			count += mesh->getVertexCount();
 
-		for (int count = 0; count < meshes.size(); ++count)
-		{
-			meshVertices = meshes[count]->getVertexList();
-			for (std::list<Vertex*>::iterator it = meshVertices.begin(); it != meshVertices.end(); ++it)
-				allVertices.push_back((*it));
-		}
-
-		return allVertices;
+		return count;
 	}
 
 	std::list<unsigned int> Model::getFacesList()
@@ -236,7 +384,7 @@ namespace Glitter
 			for (std::list<unsigned int>::iterator it = meshFaces.begin(); it != meshFaces.end(); ++it)
 				allFaces.push_back((*it) + faceOffset);
 
-			faceOffset += meshes[count]->getVertexList().size();
+			faceOffset += meshes[count]->getVertexCount();
 		}
 
 		return allFaces;
@@ -360,19 +508,34 @@ namespace Glitter
 			globalAABB.merge(mesh->getAABB());
 	}
 
-	void Model::mergeModel(Model* model, Matrix4 transform, float uv2_left, float uv2_right, float uv2_top, float uv2_bottom)
+	size_t Model::mergeModel(Model* model, Matrix4 transform, float uv2_left, float uv2_right, float uv2_top, float uv2_bottom,
+		const VertexWeldOptions& weldOptions)
 	{
+		size_t welded = 0;
 		std::vector<Mesh*> mergeMeshes = model->getMeshes();
+		meshes.reserve(meshes.size() + mergeMeshes.size());
 		for (std::vector<Mesh*>::iterator it = mergeMeshes.begin(); it != mergeMeshes.end(); it++)
-			cloneMesh(*it, transform, uv2_left, uv2_right, uv2_top, uv2_bottom);
+			welded += cloneMesh(*it, transform, uv2_left, uv2_right, uv2_top, uv2_bottom, weldOptions);
 
 		buildAABB();
+		return welded;
 	}
 
-	void Model::cloneMesh(Mesh* mesh, Matrix4 transform, float uv2_left, float uv2_right, float uv2_top, float uv2_bottom)
+	size_t Model::cloneMesh(Mesh* mesh, Matrix4 transform, float uv2_left, float uv2_right, float uv2_top, float uv2_bottom,
+		const VertexWeldOptions& weldOptions)
 	{
 		Mesh* cloneMesh = new Mesh(mesh, transform, uv2_left, uv2_right, uv2_top, uv2_bottom);
 		meshes.push_back(cloneMesh);
+
+		// each clone is welded on its own, so merging many instances stays linear
+		size_t welded = 0;
+		for (Submesh* submesh : cloneMesh->getSubmeshes())
+		{
+			const VertexWeldReport& report = submesh->weld(weldOptions);
+			welded += report.inputVertices - report.outputVertices;
+		}
+
+		return welded;
 	}
 
 	void Model::save(std::string filename_p, int rootType)
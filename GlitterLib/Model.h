@@ -15,10 +15,16 @@ namespace Glitter
 		std::string filename;
 		unsigned int modelFlag;
 		bool terrainMode;
+		bool keepStrips;
 		AABB globalAABB;
+
+		static bool parallelDecoding;
+
+		void decodeSubmeshes();
+
 	public:
 		Model();
-		Model(std::string filename);
+		Model(std::string filename, bool keepStrips = true);
 		Model(BinaryReader* reader, bool terrainMode);
 		~Model();
 
@@ -27,7 +33,7 @@ namespace Glitter
 		AABB getAABB();
 		std::string getName();
 		std::string getFilename();
-		std::list<Vertex*> getVertexList();
+		size_t getVertexCount() const;
 		std::list<unsigned int> getFacesList();
 		std::list<std::string> getMaterialNames();
 		std::vector<unsigned int> getMaterialMappings(std::list<std::string>& materialNames);
@@ -40,11 +46,16 @@ namespace Glitter
 		void buildAABB();
 		void fixVertexFormatForPC();
 		void setName(std::string name);
-		void getTotalData(std::list<Vertex*> &vertexList, std::list<unsigned int> &facesList, std::list<std::string> &materialNames, std::vector<unsigned int> &materialMappings);
+		void getTotalData(std::vector<Vertex> &vertexList, std::list<unsigned int> &facesList, std::list<std::string> &materialNames, std::vector<unsigned int> &materialMappings);
 		void addMesh(Mesh* mesh);
-		void cloneMesh(Mesh* mesh, Matrix4 transform, float uv2Left, float uv2Right, float uv2Top, float uv2Bottom);
-		void mergeModel(Model* model, Matrix4 transform, float uv2Left, float uv2Right, float uv2Top, float uv2Bottom);
+		size_t cloneMesh(Mesh* mesh, Matrix4 transform, float uv2Left, float uv2Right, float uv2Top, float uv2Bottom,
+			const VertexWeldOptions& weldOptions = VertexWeldOptions());
+		size_t mergeModel(Model* model, Matrix4 transform, float uv2Left, float uv2Right, float uv2Top, float uv2Bottom,
+			const VertexWeldOptions& weldOptions = VertexWeldOptions());
 		void changeVertexFormat(int format);
 
+		static void setParallelDecoding(bool enabled);
+		static bool isParallelDecoding();
+
 	};
 }
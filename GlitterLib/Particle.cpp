@@ -200,7 +200,7 @@ namespace Glitter
 
 	float Particle::getReflectionCoeffRandom() const
 	{
-		return reflectionCoeff;
+		return reflectionCoeffRandom;
 	}
 
 	float Particle::getReboundPlaneY() const
@@ -1,5 +1,5 @@
 #include "Submesh.h"
-#include "../tristripper/tri_stripper.h"
+#include "VertexDecodePlan.h"
 
 namespace Glitter
 {
@@ -7,18 +7,15 @@ namespace Glitter
 	{
 		materialName = MODEL_SUBMESH_UNKNOWN_MATERIAL;
 		vertexFormat = nullptr;
+		sourceEndianness = Endianness::BIG;
 		extra = "";
 	}
 
 	Submesh::Submesh(Submesh* clone, Matrix4 transform, float uv2Left, float uv2Right, float uv2Top, float uv2Bottom)
 	{
-		size_t vertSize = clone->getVerticesSize();
-		for (int i = 0; i < vertSize; ++i)
-		{
-			Vertex* vertex = new Vertex(clone->vertices[i], transform, uv2Left, uv2Right, uv2Top, uv2Bottom);
-			vertex->setParent(this);
-			vertices.push_back(vertex);
-		}
+		// copy the whole stream, then transform it in place
+		vertices = clone->vertices;
+		Vertex::transformStream(vertices.data(), vertices.size(), transform, uv2Left, uv2Right, uv2Top, uv2Bottom);
 
 		faces = clone->faces;
 		facesVectors = clone->facesVectors;
@@ -27,25 +24,19 @@ namespace Glitter
 		textureIds = clone->textureIds;
 		materialName = clone->materialName;
 		vertexFormat = new VertexFormat(clone->vertexFormat);
+		sourceEndianness = clone->sourceEndianness;
 		buildAABB();
 	}
 
 	Submesh::~Submesh()
 	{
-		for (std::vector<Vertex*>::iterator it = vertices.begin(); it != vertices.end(); ++it)
-			delete (*it);
-
-		vertices.clear();
-
 		if (vertexFormat)
 			delete vertexFormat;
 	}
 
-	std::list<Vertex*> Submesh::getVerticesList() const
+	const std::vector<Vertex>& Submesh::getVertices() const
 	{ 
-		std::list<Vertex*> newList;
-		std::copy(vertices.begin(), vertices.end(), std::back_inserter(newList));
-		return newList;
+		return vertices;
 	}
 
 	std::list<unsigned int> Submesh::getFacesList() const
@@ -66,6 +57,11 @@ namespace Glitter
 		return facesVectors;
 	}
 
+	const std::vector<Polygon>& Submesh::getTriangles() const
+	{
+		return facesVectors;
+	}
+
 	std::vector<unsigned char> Submesh::getBoneTable() const
 	{ 
 		return boneTable;
@@ -127,6 +123,16 @@ namespace Glitter
 		return faces.size();
 	}
 
+	const IndexBuildReport& Submesh::getBuildReport() const
+	{
+		return buildReport;
+	}
+
+	const VertexWeldReport& Submesh::getWeldReport() const
+	{
+		return weldReport;
+	}
+
 	void Submesh::setExtra(std::string ex)
 	{ 
 		extra = ex;
@@ -168,78 +174,31 @@ namespace Glitter
 		return vertexFormat->getSize() * vertices.size() + faces.size() * 2;
 	}
 
-	void Submesh::build(std::vector<Vertex*> vertices, std::vector<Polygon> facesVectors)
+	void Submesh::build(std::vector<Vertex> vertices, std::vector<Polygon> facesVectors, const IndexOptimizerOptions& options,
+		const VertexWeldOptions& weldOptions)
 	{
-		this->vertices = vertices;
-		this->facesVectors = facesVectors;
-
-		std::vector<Vertex*> new_vertices;
-		new_vertices.clear();
-
-		std::vector<unsigned short> newFaceMap;
-		newFaceMap.clear();
-
-		for (size_t x = 0; x < vertices.size(); x++) {
-			Vertex* v = vertices[x];
-
-			bool clone = false;
-			for (unsigned int y = 0; y < new_vertices.size(); y++) {
-				if ((*new_vertices[y]) == (*v)) {
-					clone = true;
-					newFaceMap.push_back(y);
-					delete v;
-					break;
-				}
-			}
-
-			if (!clone) {
-				new_vertices.push_back(v);
-				newFaceMap.push_back(new_vertices.size() - 1);
-			}
-		}
-
-		vertices = new_vertices;
-
-		for (size_t i = 0; i < facesVectors.size(); i++) {
-			facesVectors[i].a = newFaceMap[(int)facesVectors[i].a];
-			facesVectors[i].b = newFaceMap[(int)facesVectors[i].b];
-			facesVectors[i].c = newFaceMap[(int)facesVectors[i].c];
-		}
-
+		std::vector<unsigned int> remap;
+		weldReport = VertexWelder::weld(vertices, remap, weldOptions);
+		VertexWelder::remapTriangles(facesVectors, remap);
+		this->vertices = std::move(vertices);
 
-		triangle_stripper::indices tri_indices;
-		for (size_t i = 0; i < facesVectors.size(); i++) {
-			tri_indices.push_back((int)facesVectors[i].a);
-			tri_indices.push_back((int)facesVectors[i].b);
-			tri_indices.push_back((int)facesVectors[i].c);
-		}
+		// reorder for the vertex cache and overdraw, then join into strips
+		faces.clear();
+		buildReport = IndexOptimizer::optimize(facesVectors, this->vertices, faces, options);
+		this->facesVectors = std::move(facesVectors);
 
-		triangle_stripper::tri_stripper stripper(tri_indices);
-		stripper.SetCacheSize(0);
-		stripper.SetBackwardSearch(false);
-		triangle_stripper::primitive_vector out_vector;
-		stripper.Strip(&out_vector);
-
-		for (size_t i = 0; i < out_vector.size(); i += 1) {
-			if (out_vector[i].Type == triangle_stripper::TRIANGLE_STRIP) {
-				for (size_t j = 0; j < out_vector[i].Indices.size(); j++) {
-					faces.push_back(out_vector[i].Indices[j]);
-				}
-				faces.push_back(0xFFFF);
-			}
-			else {
-				for (size_t j = 0; j < out_vector[i].Indices.size(); j += 3) {
-					faces.push_back(out_vector[i].Indices[j]);
-					faces.push_back(out_vector[i].Indices[j + 1]);
-					faces.push_back(out_vector[i].Indices[j + 2]);
-					faces.push_back(0xFFFF);
-				}
-			}
-		}
+		buildAABB();
+	}
 
-		if (faces[faces.size() - 1] == 0xFFFF) faces.resize(faces.size() - 1);
+	const VertexWeldReport& Submesh::weld(const VertexWeldOptions& options)
+	{
+		// strips keep their layout, only the indices change
+		std::vector<unsigned int> remap;
+		weldReport = VertexWelder::weld(vertices, remap, options);
+		VertexWelder::remapTriangles(facesVectors, remap);
+		VertexWelder::remapStrips(faces, remap);
 
-		buildAABB();
+		return weldReport;
 	}
 
 	void Submesh::fixVertexFormatForPC()
@@ -252,12 +211,19 @@ namespace Glitter
 	{
 		aabb.reset();
 		for (int i = 0; i < vertices.size(); ++i)
-			aabb.addPoint(vertices[i]->getPosition());
+			aabb.addPoint(vertices[i].getPosition());
 	}
 
 	void Submesh::read(BinaryReader* reader)
+	{
+		readBuffers(reader);
+		decode();
+	}
+
+	void Submesh::readBuffers(BinaryReader* reader)
 	{
 		size_t header = reader->getCurrentAddress();
+		sourceEndianness = reader->getEndianness();
 
 		// header
 		size_t materialNameAddress = reader->readAddress();
@@ -273,59 +239,11 @@ namespace Glitter
 		unsigned int textureUnitSize = reader->readInt32();
 		size_t textureUnitAddress = reader->readAddress();
 
+		// faces are swapped when decoded
 		reader->gotoAddress(facesAddress);
-		faces.reserve(facesCount);
-		for (int i = 0; i < facesCount; ++i)
-		{
-			unsigned short face = reader->readInt16();
-			faces.push_back(face);
-		}
-
-		// convert faces to triangle strips
-		unsigned short int face1 = 0;
-		unsigned short int face2 = 0;
-		unsigned short int face3 = 0;
-		unsigned short int lastFace = 0;
-
-		int newStrip = 3;
-		int newIndex = 0;
-
-		facesVectors.reserve(facesCount);
-		for (int i = 0; i < facesCount; ++i)
-		{
-			unsigned short int t = faces[i];
-			if (t == 0xffff)
-			{
-				newStrip = 3;
-				newIndex = 0;
-			}
-			else
-			{
-				if (newStrip == 3)
-					lastFace = t;
-
-				newStrip -= 1;
-				face3 = face2;
-				face2 = face1;
-				face1 = t;
-				
-				if (newStrip == 0)
-				{
-					Polygon poly = { face1, face2, face3 };
-					Polygon invPoly = { face3, face2, face1 };
-
-					if ((face1 != face2) && (face2 != face3) && (face1 != face3))
-					{
-						facesVectors.push_back((newIndex % 2) ? invPoly : poly);
-					}
-
-					newStrip = 1;
-					++newIndex;
-				}
-			}
-		}
-
-		facesVectors.shrink_to_fit();
+		faces.resize(facesCount);
+		if (facesCount)
+			reader->readSize(faces.data(), facesCount * sizeof(unsigned short));
 
 		// vertex format
 		reader->gotoAddress(vertexFormatAddress);
@@ -333,28 +251,21 @@ namespace Glitter
 		vertexFormat->read(reader);
 		vertexFormat->setSize(vertexSize);
 
-		vertices.reserve(verticesCount);
-
-		// vertices
-		for (int i = 0; i < verticesCount; ++i)
+		// vertices are kept as raw bytes until decoded, but the count is known now
+		vertices.resize(verticesCount);
+		if (verticesCount && vertexSize)
 		{
-			reader->gotoAddress(verticesAddress + i * vertexSize);
-
-			Vertex* v = new Vertex();
-			v->read(reader, vertexFormat);
-			v->setParent(this);
-			vertices.push_back(v);
+			vertexData.resize((size_t)verticesCount * vertexSize);
+			reader->gotoAddress(verticesAddress);
+			reader->readSize(vertexData.data(), vertexData.size());
 		}
 
-		boneTable.reserve(bonesSize);
-
 		// bone table
-		for (int i = 0; i < bonesSize; ++i)
+		boneTable.resize(bonesSize);
+		if (bonesSize)
 		{
 			reader->gotoAddress(bonesAddress);
-
-			unsigned char bone = reader->readChar();
-			boneTable.push_back(bone);
+			reader->readSize(boneTable.data(), bonesSize);
 		}
 
 		textureUnits.reserve(textureUnitSize);
@@ -381,10 +292,75 @@ namespace Glitter
 		materialName = reader->readString();
 	}
 
+	size_t Submesh::convertStrips(const unsigned short* strip, size_t count, Polygon* out)
+	{
+		size_t written = 0;
+		size_t start = 0;
+		for (size_t i = 0; i <= count; ++i)
+		{
+			if (i < count && strip[i] != 0xFFFF)
+				continue;
+
+			// strip[start, i) is one strip; winding flips on every other triangle and degenerates are dropped
+			for (size_t k = start + 2; k < i; ++k)
+			{
+				unsigned int a = strip[k - 2];
+				unsigned int b = strip[k - 1];
+				unsigned int c = strip[k];
+				if (a == b || b == c || a == c)
+					continue;
+
+				if (out)
+					out[written] = ((k - start) & 1) ? Polygon{ a, b, c } : Polygon{ c, b, a };
+
+				++written;
+			}
+
+			start = i + 1;
+		}
+
+		return written;
+	}
+
+	void Submesh::decode(bool keepStrips)
+	{
+		if (sourceEndianness == Endianness::BIG)
+		{
+			for (unsigned short& face : faces)
+				face = (unsigned short)((face >> 8) | (face << 8));
+		}
+
+		// count first so the triangle list is allocated once at its final size
+		facesVectors.resize(convertStrips(faces.data(), faces.size(), nullptr));
+		convertStrips(faces.data(), faces.size(), facesVectors.data());
+
+		if (!keepStrips)
+		{
+			faces.clear();
+			faces.shrink_to_fit();
+		}
+
+		// decode the whole buffer with the format resolved up front
+		if (vertexData.size())
+		{
+			VertexDecodePlan plan(vertexFormat, vertexFormat->getSize(), sourceEndianness);
+			plan.decode(vertexData.data(), vertices.size(), vertices.data());
+		}
+
+		vertexData.clear();
+		vertexData.shrink_to_fit();
+
+		buildAABB();
+	}
+
 	void Submesh::write(BinaryWriter* writer)
 	{
 		size_t headerAddress = writer->getCurrentAddress();
 
+		// strips may have been dropped after decoding; rejoin them from the triangle list
+		if (faces.empty() && facesVectors.size())
+			IndexOptimizer::stripify(facesVectors, faces);
+
 		//header
 		size_t materialNameAddress = 0;
 		unsigned int facesCount = faces.size();
@@ -420,7 +396,7 @@ namespace Glitter
 		// vertices
 		verticesAddress = writer->getCurrentAddress();
 		for (int i = 0; i < verticesCount; ++i)
-			vertices[i]->write(writer, vertexFormat);
+			vertices[i].write(writer, vertexFormat);
 
 		// vertex format
 		vertexFormatAddress = writer->getCurrentAddress();
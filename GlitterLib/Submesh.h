@@ -4,6 +4,8 @@
 #include <string>
 #include "Vertex.h"
 #include "VertexFormat.h"
+#include "IndexOptimizer.h"
+#include "VertexWelder.h"
 
 namespace Glitter
 {
@@ -14,10 +16,13 @@ namespace Glitter
 		unsigned int a, b, c;
 	};
 
+	// triangle lists are handed to index buffers as-is
+	static_assert(sizeof(Polygon) == sizeof(unsigned int) * 3, "Polygon must be three tightly packed indices");
+
 	class Submesh
 	{
 	private:
-		std::vector<Vertex*> vertices;
+		std::vector<Vertex> vertices;
 		std::vector<unsigned short> faces;
 		std::vector<Polygon> facesVectors;
 		std::vector<unsigned char> boneTable;
@@ -28,15 +33,20 @@ namespace Glitter
 		AABB aabb;
 		std::string extra;
 		std::vector<Vector3> points;
+		std::vector<unsigned char> vertexData;
+		Endianness sourceEndianness;
+		IndexBuildReport buildReport;
+		VertexWeldReport weldReport;
 
 	public:
 		Submesh();
 		Submesh(Submesh* clone, Matrix4 transform, float uv2Left, float uv2Right, float uv2Top, float uv2Bottom);
 		~Submesh();
 
-		std::list<Vertex*> getVerticesList() const;
+		const std::vector<Vertex>& getVertices() const;
 		std::list<unsigned int> getFacesList() const;
 		std::vector<Polygon> getFaces() const;
+		const std::vector<Polygon>& getTriangles() const;
 		std::vector<unsigned char> getBoneTable() const;
 		std::vector<std::string> getTextureUnits() const;
 		std::vector<unsigned int> getTextureIds() const;
@@ -49,9 +59,13 @@ namespace Glitter
 		unsigned char getBone(unsigned int index) const;
 		size_t getVerticesSize() const;
 		size_t getFacesSize() const;
+		const IndexBuildReport& getBuildReport() const;
+		const VertexWeldReport& getWeldReport() const;
 		
 		unsigned int getEstimatedMemorySize() const;
-		void build(std::vector<Vertex*> vertices, std::vector<Polygon> faceVectors);
+		void build(std::vector<Vertex> vertices, std::vector<Polygon> faceVectors, const IndexOptimizerOptions& options = IndexOptimizerOptions(),
+			const VertexWeldOptions& weldOptions = VertexWeldOptions());
+		const VertexWeldReport& weld(const VertexWeldOptions& options = VertexWeldOptions());
 		void fixVertexFormatForPC();
 		void buildAABB();
 		void setExtra(std::string ex);
@@ -62,6 +76,10 @@ namespace Glitter
 		void addTextureId(unsigned int id);
 		void changeVertexFormat(int vformat);
 		void read(BinaryReader* reader);
+		void readBuffers(BinaryReader* reader);
+		void decode(bool keepStrips = true);
+
+		static size_t convertStrips(const unsigned short* strip, size_t count, Polygon* out);
 		void write(BinaryWriter* writer);
 
 	};
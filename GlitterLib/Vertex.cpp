@@ -1,4 +1,5 @@
 #include "Vertex.h"
+#include "../Dependencies/DirectXMath-master/Inc/DirectXMath.h"
 #include <list>
 
 namespace Glitter
@@ -19,35 +20,59 @@ namespace Glitter
 		color = Color();
 	}
 
-	Vertex::Vertex(Vertex* clone, Matrix4 transform, float uv2Left, float uv2Right, float uv2Top, float uv2Bottom)
+	Vertex::Vertex(const Vertex& clone, Matrix4 transform, float uv2Left, float uv2Right, float uv2Top, float uv2Bottom) :
+		Vertex(clone)
 	{
+		transformStream(this, 1, transform, uv2Left, uv2Right, uv2Top, uv2Bottom);
+	}
+
+	void Vertex::transformStream(Vertex* vertices, size_t count, Matrix4 transform, float uv2Left, float uv2Right, float uv2Top, float uv2Bottom)
+	{
+		using namespace DirectX;
+
+		if (!count)
+			return;
+
+		// the frame only takes the rotation, so it's decomposed once for the whole stream
 		Vector3 pos, scale;
 		Quaternion orient;
 		transform.decomposition(pos, scale, orient);
 
-		position = transform * clone->position;
-		normal = orient * clone->normal;
-		tangent = orient * clone->tangent;
-		binormal = orient * clone->binormal;
-		color = clone->color;
-		normal.normalise();
-		tangent.normalise();
-		binormal.normalise();
+		Vector3 axes[3] = { Vector3(1.0f, 0.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f), Vector3(0.0f, 0.0f, 1.0f) };
+		for (Vector3& axis : axes)
+			axis = orient * axis;
 
-		for (int i = 0; i < 4; ++i)
-		{
-			uv[i] = clone->uv[i];
-			boneIndices[i] = clone->boneIndices[i];
-			boneWeights[i] = clone->boneIndices[i];
-		}
+		// Matrix4 transforms column vectors, DirectXMath row vectors
+		XMFLOAT4X4 columns(&transform.m[0][0]);
+		XMMATRIX matrix = XMMatrixTranspose(XMLoadFloat4x4(&columns));
+		XMMATRIX rotation(
+			axes[0].x, axes[0].y, axes[0].z, 0.0f,
+			axes[1].x, axes[1].y, axes[1].z, 0.0f,
+			axes[2].x, axes[2].y, axes[2].z, 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f);
 
-		uv[1].x = uv2Left + uv[1].x * (uv2Right - uv2Left);
-		uv[1].y = uv2Top + uv[1].y * (uv2Bottom - uv2Top);
+		XMVECTOR uvScale = XMVectorSet(uv2Right - uv2Left, uv2Bottom - uv2Top, 0.0f, 0.0f);
+		XMVECTOR uvOffset = XMVectorSet(uv2Left, uv2Top, 0.0f, 0.0f);
 
-		parent = nullptr;
+		// one pass over the stream; everything else in the vertex is left as it is
+		for (size_t i = 0; i < count; ++i)
+		{
+			Vertex& v = vertices[i];
+			XMFLOAT3* position = (XMFLOAT3*)&v.position;
+			XMFLOAT3* normal = (XMFLOAT3*)&v.normal;
+			XMFLOAT3* tangent = (XMFLOAT3*)&v.tangent;
+			XMFLOAT3* binormal = (XMFLOAT3*)&v.binormal;
+			XMFLOAT2* uv2 = (XMFLOAT2*)&v.uv[1];
+
+			XMStoreFloat3(position, XMVector3TransformCoord(XMLoadFloat3(position), matrix));
+			XMStoreFloat3(normal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(normal), rotation)));
+			XMStoreFloat3(tangent, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(tangent), rotation)));
+			XMStoreFloat3(binormal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(binormal), rotation)));
+			XMStoreFloat2(uv2, XMVectorMultiplyAdd(XMLoadFloat2(uv2), uvScale, uvOffset));
+		}
 	}
 
-	bool Vertex::operator==(const Vertex& vertex)
+	bool Vertex::operator==(const Vertex& vertex) const
 	{
 		if (position != vertex.position) return false;
 		if (normal != vertex.normal) return false;
@@ -65,28 +90,26 @@ namespace Glitter
 		return true;
 	}
 
-	Vector3 Vertex::getTransformPosition(const Matrix4& matrix)
+	Vector3 Vertex::getTransformPosition(const Matrix4& matrix) const
 	{
 		return matrix * position;
 	}
 
-	Vector3 Vertex::getPosition() { return position; }
-
-	Vector3 Vertex::getNormal() { return normal; }
+	Vector3 Vertex::getPosition() const { return position; }
 
-	Vector3 Vertex::getBinormal() { return binormal; }
+	Vector3 Vertex::getNormal() const { return normal; }
 
-	Vector3 Vertex::getTangent() { return tangent; }
+	Vector3 Vertex::getBinormal() const { return binormal; }
 
-	Vector2 Vertex::getUV(unsigned int channel) { return uv[channel]; }
+	Vector3 Vertex::getTangent() const { return tangent; }
 
-	unsigned int Vertex::getBoneIndex(unsigned int index) { return boneIndices[index]; }
+	Vector2 Vertex::getUV(unsigned int channel) const { return uv[channel]; }
 
-	unsigned int Vertex::getBoneWeight(unsigned int index) { return boneWeights[index]; }
+	unsigned int Vertex::getBoneIndex(unsigned int index) const { return boneIndices[index]; }
 
-	Submesh* Vertex::getParent() { return parent; }
+	unsigned int Vertex::getBoneWeight(unsigned int index) const { return boneWeights[index]; }
 
-	Color Vertex::getColor() { return color; }
+	Color Vertex::getColor() const { return color; }
 
 	void Vertex::setPosition(Vector3 pos) { position = pos; }
 
@@ -96,8 +119,6 @@ namespace Glitter
 
 	void Vertex::setBinormal(Vector3 binorm) { binormal = binorm; }
 
-	void Vertex::setParent(Submesh* submesh) { parent = submesh; }
-
 	void Vertex::setColor(Color c) { color = c; }
 
 	void Vertex::setUV(Vector2 v2, unsigned int index)
@@ -1,5 +1,4 @@
 #pragma once
-#include "Submesh.h"
 #include "VertexFormat.h"
 #include "MathGens.h"
 #include "BinaryReader.h"
@@ -8,8 +7,6 @@
 
 namespace Glitter
 {
-	class Submesh;
-
 	class Vertex
 	{
 	private:
@@ -20,24 +17,25 @@ namespace Glitter
 		Vector2 uv[4];
 		unsigned char boneIndices[4];
 		unsigned char boneWeights[4];
-		Submesh* parent;
 		Color color;
 
+		friend class VertexDecodePlan;
+		friend class VertexWelder;
+
 	public:
 		Vertex();
-		Vertex(Vertex* clone, Matrix4 transform, float uv2Left, float uv2Right, float uv2Top, float uv2Bottom);
+		Vertex(const Vertex& clone, Matrix4 transform, float uv2Left, float uv2Right, float uv2Top, float uv2Bottom);
 
-		bool operator==(const Vertex& v);
-		Vector3 getTransformPosition(const Matrix4& m);
-		Vector3 getPosition();
-		Vector3 getNormal();
-		Vector3 getTangent();
-		Vector3 getBinormal();
-		Vector2 getUV(unsigned int channel);
-		unsigned int getBoneIndex(unsigned int index);
-		unsigned int getBoneWeight(unsigned int index);
-		Submesh* getParent();
-		Color getColor();
+		bool operator==(const Vertex& v) const;
+		Vector3 getTransformPosition(const Matrix4& m) const;
+		Vector3 getPosition() const;
+		Vector3 getNormal() const;
+		Vector3 getTangent() const;
+		Vector3 getBinormal() const;
+		Vector2 getUV(unsigned int channel) const;
+		unsigned int getBoneIndex(unsigned int index) const;
+		unsigned int getBoneWeight(unsigned int index) const;
+		Color getColor() const;
 		void setPosition(Vector3 pos);
 		void setNormal(Vector3 norm);
 		void setTangnet(Vector3 tan);
@@ -45,10 +43,12 @@ namespace Glitter
 		void setUV(Vector2 uv, unsigned int index);
 		void setBoneIndex(unsigned char value, unsigned int index);
 		void setBoneWeight(unsigned char weight, unsigned int index);
-		void setParent(Submesh* parent);
 		void setColor(Color color);
 		void transform(const Matrix4& m);
 
+		// transforms a whole vertex stream in place, the same way the cloning constructor does one vertex
+		static void transformStream(Vertex* vertices, size_t count, Matrix4 transform, float uv2Left, float uv2Right, float uv2Top, float uv2Bottom);
+
 		void read(BinaryReader *reader, VertexFormat* vformat);
 		void write(BinaryWriter* writer, VertexFormat* vformat);
 	};
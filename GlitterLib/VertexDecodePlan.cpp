@@ -0,0 +1,206 @@
+#include "VertexDecodePlan.h"
+#include "Vertex.h"
+#include <half.hpp>
+#include <cstring>
+
+namespace Glitter
+{
+	template<bool Swap>
+	uint32_t VertexDecodePlan::loadInt32(const unsigned char* src)
+	{
+		uint32_t value;
+		std::memcpy(&value, src, sizeof(uint32_t));
+		if (Swap)
+			value = (value >> 24) | (value << 24) | ((value << 8) & 0x00ff0000) | ((value >> 8) & 0x0000ff00);
+
+		return value;
+	}
+
+	template<bool Swap>
+	uint16_t VertexDecodePlan::loadInt16(const unsigned char* src)
+	{
+		uint16_t value;
+		std::memcpy(&value, src, sizeof(uint16_t));
+		if (Swap)
+			value = (uint16_t)((value >> 8) | (value << 8));
+
+		return value;
+	}
+
+	template<bool Swap>
+	float VertexDecodePlan::loadSingle(const unsigned char* src)
+	{
+		uint32_t bits = loadInt32<Swap>(src);
+		float value;
+		std::memcpy(&value, &bits, sizeof(float));
+
+		return value;
+	}
+
+	template<Vector3 Vertex::*Member, bool Swap>
+	void VertexDecodePlan::decodeVector3(const unsigned char* src, Vertex& vertex, unsigned short index)
+	{
+		Vector3& v3 = vertex.*Member;
+		v3.x = loadSingle<Swap>(src);
+		v3.y = loadSingle<Swap>(src + 4);
+		v3.z = loadSingle<Swap>(src + 8);
+	}
+
+	template<Vector3 Vertex::*Member, bool Swap>
+	void VertexDecodePlan::decodeVector3Normal360(const unsigned char* src, Vertex& vertex, unsigned short index)
+	{
+		// same packing as BinaryReader::readVector3Normal360
+		uint32_t value = loadInt32<Swap>(src);
+
+		Vector3& v3 = vertex.*Member;
+		v3.x = ((value & 0x00000400 ? -1 : 0) + (float)((value >> 2) & 0x0FF) / 256.0f);
+		v3.y = ((value & 0x00200000 ? -1 : 0) + (float)((value >> 13) & 0x0FF) / 256.0f);
+		v3.z = ((value & 0x80000000 ? -1 : 0) + (float)((value >> 23) & 0x0FF) / 256.0f);
+	}
+
+	template<bool Swap>
+	void VertexDecodePlan::decodeVector2(const unsigned char* src, Vertex& vertex, unsigned short index)
+	{
+		vertex.uv[index].x = loadSingle<Swap>(src);
+		vertex.uv[index].y = loadSingle<Swap>(src + 4);
+	}
+
+	template<bool Swap>
+	void VertexDecodePlan::decodeVector2Half(const unsigned char* src, Vertex& vertex, unsigned short index)
+	{
+		vertex.uv[index].x = half_float::detail::half2float<float>(loadInt16<Swap>(src));
+		vertex.uv[index].y = half_float::detail::half2float<float>(loadInt16<Swap>(src + 2));
+	}
+
+	template<bool Swap>
+	void VertexDecodePlan::decodeRGBA(const unsigned char* src, Vertex& vertex, unsigned short index)
+	{
+		vertex.color.r = loadSingle<Swap>(src);
+		vertex.color.g = loadSingle<Swap>(src + 4);
+		vertex.color.b = loadSingle<Swap>(src + 8);
+		vertex.color.a = loadSingle<Swap>(src + 12);
+	}
+
+	template<unsigned char (Vertex::*Member)[4]>
+	void VertexDecodePlan::decodeBytes4(const unsigned char* src, Vertex& vertex, unsigned short index)
+	{
+		std::memcpy(vertex.*Member, src, 4);
+	}
+
+	void VertexDecodePlan::decodeABGR8(const unsigned char* src, Vertex& vertex, unsigned short index)
+	{
+		vertex.color.a = ((float)src[0]) / COLOR_CHAR;
+		vertex.color.b = ((float)src[1]) / COLOR_CHAR;
+		vertex.color.g = ((float)src[2]) / COLOR_CHAR;
+		vertex.color.r = ((float)src[3]) / COLOR_CHAR;
+	}
+
+	unsigned int VertexDecodePlan::getElementSize(VertexElementData data)
+	{
+		switch (data)
+		{
+		case VECTOR3:		return 12;
+		case VECTOR2:		return 8;
+		case VECTOR4:		return 16;
+		case VECTOR3_360:
+		case VECTOR2_HALF:
+		case INDICESB:
+		case INDICES:
+		case VECTOR4_CHAR:	return 4;
+		}
+
+		return 0;
+	}
+
+	// element and data combinations not listed here were skipped by Vertex::read as well
+	template<bool Swap>
+	VertexElementDecoder VertexDecodePlan::getDecoder(const VertexFormatElement& element)
+	{
+		VertexElementData data = element.getData();
+		switch (element.getId())
+		{
+		case POSITION:
+			if (data == VECTOR3) return &decodeVector3<&Vertex::position, Swap>;
+			break;
+		case BONE_WEIGHTS:
+			if (data == VECTOR4_CHAR) return &decodeBytes4<&Vertex::boneWeights>;
+			break;
+		case BONE_INDICES:
+			if (data == INDICES) return &decodeBytes4<&Vertex::boneIndices>;
+			break;
+		case NORMAL:
+			if (data == VECTOR3) return &decodeVector3<&Vertex::normal, Swap>;
+			if (data == VECTOR3_360) return &decodeVector3Normal360<&Vertex::normal, Swap>;
+			break;
+		case UV:
+			if (element.getIndex() >= 4) break;
+			if (data == VECTOR2) return &decodeVector2<Swap>;
+			if (data == VECTOR2_HALF) return &decodeVector2Half<Swap>;
+			break;
+		case BINORMAL:
+			if (data == VECTOR3) return &decodeVector3<&Vertex::binormal, Swap>;
+			if (data == VECTOR3_360) return &decodeVector3Normal360<&Vertex::binormal, Swap>;
+			break;
+		case TANGENT:
+			if (data == VECTOR3) return &decodeVector3<&Vertex::tangent, Swap>;
+			if (data == VECTOR3_360) return &decodeVector3Normal360<&Vertex::tangent, Swap>;
+			break;
+		case RGBA:
+			if (data == VECTOR4) return &decodeRGBA<Swap>;
+			if (data == VECTOR4_CHAR) return &decodeABGR8;
+			break;
+		}
+
+		return nullptr;
+	}
+
+	VertexDecodePlan::VertexDecodePlan(VertexFormat* vformat, unsigned int stride, Endianness endianness) :
+		stride{ stride }
+	{
+		std::list<VertexFormatElement> elements = vformat->getElements();
+		steps.reserve(elements.size());
+
+		for (const VertexFormatElement& element : elements)
+		{
+			VertexElementDecoder decoder = endianness == Endianness::BIG ? getDecoder<true>(element) : getDecoder<false>(element);
+			if (!decoder)
+				continue;
+
+			// elements that don't fit in the vertex would read into the next one
+			if (element.getOffset() + getElementSize(element.getData()) > stride)
+				continue;
+
+			steps.push_back(VertexDecodeStep{ decoder, element.getOffset(), element.getIndex() });
+		}
+	}
+
+	void VertexDecodePlan::decode(const unsigned char* src, Vertex& vertex) const
+	{
+		for (const VertexDecodeStep& step : steps)
+			step.decode(src + step.offset, vertex, step.index);
+
+		// Verify Bone Weights
+		unsigned char totalWeight = 0;
+		for (size_t i = 0; i < 4; i++)
+			totalWeight += vertex.boneWeights[i];
+
+		if (totalWeight != 0xFF)
+			vertex.boneWeights[0] += 0xFF - totalWeight;
+	}
+
+	void VertexDecodePlan::decode(const unsigned char* data, size_t count, Vertex* vertices) const
+	{
+		for (size_t i = 0; i < count; ++i)
+			decode(data + i * stride, vertices[i]);
+	}
+
+	size_t VertexDecodePlan::getStepCount() const
+	{
+		return steps.size();
+	}
+
+	unsigned int VertexDecodePlan::getStride() const
+	{
+		return stride;
+	}
+}
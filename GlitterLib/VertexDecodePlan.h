@@ -0,0 +1,53 @@
+#pragma once
+#include <vector>
+#include "VertexFormat.h"
+#include "Endianness.h"
+#include "MathGens.h"
+
+namespace Glitter
+{
+	class Vertex;
+
+	typedef void (*VertexElementDecoder)(const unsigned char* src, Vertex& vertex, unsigned short index);
+
+	struct VertexDecodeStep
+	{
+		VertexElementDecoder decode;
+		unsigned int offset;
+		unsigned short index;
+	};
+
+	/// <summary>
+	/// A vertex format resolved once into a flat list of element decoders.
+	/// Decodes a whole vertex buffer read in one go, instead of seeking and switching per element and vertex.
+	/// </summary>
+	class VertexDecodePlan
+	{
+	private:
+		std::vector<VertexDecodeStep> steps;
+		unsigned int stride;
+
+		template<bool Swap> static float loadSingle(const unsigned char* src);
+		template<bool Swap> static uint32_t loadInt32(const unsigned char* src);
+		template<bool Swap> static uint16_t loadInt16(const unsigned char* src);
+
+		template<Vector3 Vertex::*Member, bool Swap> static void decodeVector3(const unsigned char* src, Vertex& vertex, unsigned short index);
+		template<Vector3 Vertex::*Member, bool Swap> static void decodeVector3Normal360(const unsigned char* src, Vertex& vertex, unsigned short index);
+		template<bool Swap> static void decodeVector2(const unsigned char* src, Vertex& vertex, unsigned short index);
+		template<bool Swap> static void decodeVector2Half(const unsigned char* src, Vertex& vertex, unsigned short index);
+		template<bool Swap> static void decodeRGBA(const unsigned char* src, Vertex& vertex, unsigned short index);
+		template<unsigned char (Vertex::*Member)[4]> static void decodeBytes4(const unsigned char* src, Vertex& vertex, unsigned short index);
+		static void decodeABGR8(const unsigned char* src, Vertex& vertex, unsigned short index);
+
+		template<bool Swap> static VertexElementDecoder getDecoder(const VertexFormatElement& element);
+		static unsigned int getElementSize(VertexElementData data);
+
+	public:
+		VertexDecodePlan(VertexFormat* vformat, unsigned int stride, Endianness endianness);
+
+		void decode(const unsigned char* src, Vertex& vertex) const;
+		void decode(const unsigned char* data, size_t count, Vertex* vertices) const;
+		size_t getStepCount() const;
+		unsigned int getStride() const;
+	};
+}
@@ -0,0 +1,164 @@
+#include "VertexWelder.h"
+#include "Submesh.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace Glitter
+{
+	uint32_t VertexWelder::quantize(float value, float epsilon)
+	{
+		// -0 and 0 are the same vertex
+		if (value == 0.0f)
+			return 0;
+
+		// index of the grid point nearest to the value, cells span [cell - epsilon / 2, cell + epsilon / 2)
+		if (epsilon > 0.0f)
+		{
+			double cell = std::floor((double)value / epsilon + 0.5);
+			cell = std::max(-2147483648.0, std::min(2147483647.0, cell));
+			return (uint32_t)(int32_t)cell;
+		}
+
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(uint32_t));
+		return bits;
+	}
+
+	void VertexWelder::makeKey(const Vertex& vertex, const VertexWeldOptions& options, uint32_t* key)
+	{
+		const Vector3* vectors[4] = { &vertex.position, &vertex.normal, &vertex.tangent, &vertex.binormal };
+		for (size_t i = 0; i < 4; ++i)
+		{
+			float epsilon = i ? options.normal : options.position;
+			*key++ = quantize(vectors[i]->x, epsilon);
+			*key++ = quantize(vectors[i]->y, epsilon);
+			*key++ = quantize(vectors[i]->z, epsilon);
+		}
+
+		for (size_t i = 0; i < 4; ++i)
+		{
+			*key++ = quantize(vertex.uv[i].x, options.uv);
+			*key++ = quantize(vertex.uv[i].y, options.uv);
+		}
+
+		*key++ = quantize(vertex.color.r, options.color);
+		*key++ = quantize(vertex.color.g, options.color);
+		*key++ = quantize(vertex.color.b, options.color);
+		*key++ = quantize(vertex.color.a, options.color);
+
+		std::memcpy(key++, vertex.boneIndices, 4);
+		std::memcpy(key++, vertex.boneWeights, 4);
+	}
+
+	uint32_t VertexWelder::hashKey(const uint32_t* key)
+	{
+		// murmur2 over the key words
+		const uint32_t m = 0x5bd1e995;
+		uint32_t h = (uint32_t)(keySize * 4);
+		for (size_t i = 0; i < keySize; ++i)
+		{
+			uint32_t k = key[i] * m;
+			k ^= k >> 24;
+			h = (h * m) ^ (k * m);
+		}
+
+		h ^= h >> 13;
+		h *= m;
+		h ^= h >> 15;
+		return h;
+	}
+
+	VertexWeldReport VertexWelder::weld(std::vector<Vertex>& vertices, std::vector<unsigned int>& remap, const VertexWeldOptions& options)
+	{
+		const unsigned int empty = 0xFFFFFFFF;
+		auto start = std::chrono::high_resolution_clock::now();
+
+		VertexWeldReport report;
+		size_t count = vertices.size();
+		report.inputVertices = count;
+
+		remap.resize(count);
+		if (!options.enabled)
+		{
+			for (size_t i = 0; i < count; ++i)
+				remap[i] = i;
+
+			report.outputVertices = count;
+			return report;
+		}
+
+		std::vector<uint32_t> keys(count * keySize);
+		for (size_t i = 0; i < count; ++i)
+			makeKey(vertices[i], options, &keys[i * keySize]);
+
+		// at most half full, so probe sequences stay short
+		size_t capacity = 1;
+		while (capacity < count * 2)
+			capacity <<= 1;
+
+		std::vector<unsigned int> table(capacity, empty);
+		size_t unique = 0;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint32_t* key = &keys[i * keySize];
+			size_t slot = hashKey(key) & (capacity - 1);
+
+			while (true)
+			{
+				unsigned int entry = table[slot];
+				if (entry == empty)
+				{
+					// unique vertices are compacted in place; keys stay at their input index
+					table[slot] = i;
+					remap[i] = unique;
+					if (unique != i)
+						vertices[unique] = vertices[i];
+
+					++unique;
+					break;
+				}
+
+				if (std::memcmp(&keys[entry * keySize], key, keySize * sizeof(uint32_t)) == 0)
+				{
+					remap[i] = remap[entry];
+					break;
+				}
+
+				slot = (slot + 1) & (capacity - 1);
+			}
+		}
+
+		vertices.resize(unique);
+		report.outputVertices = unique;
+		report.time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		return report;
+	}
+
+	void VertexWelder::remapTriangles(std::vector<Polygon>& triangles, const std::vector<unsigned int>& remap)
+	{
+		// triangles that collapsed into a line or point are dropped, like degenerate strip triangles
+		size_t written = 0;
+		for (const Polygon& poly : triangles)
+		{
+			Polygon welded{ remap[poly.a], remap[poly.b], remap[poly.c] };
+			if (welded.a == welded.b || welded.b == welded.c || welded.a == welded.c)
+				continue;
+
+			triangles[written++] = welded;
+		}
+
+		triangles.resize(written);
+	}
+
+	void VertexWelder::remapStrips(std::vector<unsigned short>& strips, const std::vector<unsigned int>& remap)
+	{
+		for (unsigned short& index : strips)
+		{
+			if (index != 0xFFFF)
+				index = (unsigned short)remap[index];
+		}
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+namespace Glitter
+{
+	struct Polygon;
+	class Vertex;
+
+	// each epsilon is the spacing of the grid its attribute is snapped to; vertices whose attributes all snap to the
+	// same grid points are welded. values up to epsilon apart can be welded, but values much closer than that
+	// stay apart when a cell boundary falls between them.
+	// 0 only welds exact matches; bone indices and weights always have to match exactly.
+	struct VertexWeldOptions
+	{
+		bool enabled = true;
+		float position = 0.0f;
+		float normal = 0.0f;
+		float uv = 0.0f;
+		float color = 0.0f;
+	};
+
+	struct VertexWeldReport
+	{
+		size_t inputVertices = 0;
+		size_t outputVertices = 0;
+		double time = 0.0;
+	};
+
+	/// <summary>
+	/// Removes duplicate vertices through an open addressing hash table, in linear time.
+	/// Attributes are snapped to the nearest multiple of their epsilon before hashing, so vertices in the same grid cell are welded
+	/// and the first one of them is kept. Neighbouring cells are not searched.
+	/// </summary>
+	class VertexWelder
+	{
+	private:
+		// position, normal, tangent, binormal, 4 uv channels, color, bone indices and bone weights
+		static constexpr size_t keySize = 3 * 4 + 2 * 4 + 4 + 2;
+
+		static uint32_t quantize(float value, float epsilon);
+		static void makeKey(const Vertex& vertex, const VertexWeldOptions& options, uint32_t* key);
+		static uint32_t hashKey(const uint32_t* key);
+
+	public:
+		static VertexWeldReport weld(std::vector<Vertex>& vertices, std::vector<unsigned int>& remap, const VertexWeldOptions& options = VertexWeldOptions());
+		static void remapTriangles(std::vector<Polygon>& triangles, const std::vector<unsigned int>& remap);
+		static void remapStrips(std::vector<unsigned short>& strips, const std::vector<unsigned int>& remap);
+	};
+}
@@ -14,13 +14,13 @@ namespace Glitter
 		void AddAnimationCommand::execute()
 		{
 			set.lock()->add(animation, position);
-			set.lock()->markDirty(true);
+			set.lock()->markDirty();
 		}
 
 		void AddAnimationCommand::undo()
 		{
 			set.lock()->remove(position);
-			set.lock()->markDirty(true);
+			set.lock()->markDirty();
 		}
 
 		RemoveAnimationCommand::RemoveAnimationCommand(std::shared_ptr<EditorAnimationSet>& aSet, size_t pos) :
@@ -32,13 +32,13 @@ namespace Glitter
 		void RemoveAnimationCommand::execute()
 		{
 			set.lock()->remove(position);
-			set.lock()->markDirty(true);
+			set.lock()->markDirty();
 		}
 
 		void RemoveAnimationCommand::undo()
 		{
 			set.lock()->add(animation, position);
-			set.lock()->markDirty(true);
+			set.lock()->markDirty();
 		}
 
 		ChangeAnimationCommand::ChangeAnimationCommand(std::shared_ptr<EditorAnimationSet>& aSet, EditorAnimation& anim, size_t pos) :
@@ -51,13 +51,13 @@ namespace Glitter
 		void ChangeAnimationCommand::execute()
 		{
 			set.lock()->animations[position] = newValue;
-			set.lock()->markDirty(true);
+			set.lock()->markDirty();
 		}
 
 		void ChangeAnimationCommand::undo()
 		{
 			set.lock()->animations[position] = oldValue;
-			set.lock()->markDirty(true);
+			set.lock()->markDirty();
 		}
 
 		AddKeyCommand::AddKeyCommand(std::shared_ptr<EditorAnimationSet>& aSet, size_t aIndex, int frame) :
@@ -88,13 +88,13 @@ namespace Glitter
 		void AddKeyCommand::execute()
 		{
 			keyPos = set.lock()->animations[animIndex].insertKey(key);
-			set.lock()->markDirty(true);
+			set.lock()->markDirty();
 		}
 
 		void AddKeyCommand::undo()
 		{
 			set.lock()->animations[animIndex].removeKey(keyPos);
-			set.lock()->markDirty(true);
+			set.lock()->markDirty();
 		}
 
 		RemoveKeyCommand::RemoveKeyCommand(std::shared_ptr<EditorAnimationSet>& aSet, size_t aIndex, size_t pos) :
@@ -106,13 +106,13 @@ namespace Glitter
 		void RemoveKeyCommand::execute()
 		{
 			set.lock()->animations[animIndex].removeKey(keyPos);
-			set.lock()->markDirty(true);
+			set.lock()->markDirty();
 		}
 
 		void RemoveKeyCommand::undo()
 		{
 			set.lock()->animations[animIndex].insertKey(key);
-			set.lock()->markDirty(true);
+			set.lock()->markDirty();
 		}
 
 		ChangeKeyCommand::ChangeKeyCommand(std::shared_ptr<EditorAnimationSet>& aSet, size_t aIndex, EditorKeyframe& k, size_t pos) :
@@ -124,13 +124,13 @@ namespace Glitter
 		void ChangeKeyCommand::execute()
 		{
 			set.lock()->animations[animIndex].keys[keyPos] = newValue;
-			set.lock()->markDirty(true);
+			set.lock()->markDirty();
 		}
 
 		void ChangeKeyCommand::undo()
 		{
 			set.lock()->animations[animIndex].keys[keyPos] = oldValue;
-			set.lock()->markDirty(true);
+			set.lock()->markDirty();
 		}
 	}
 }
@@ -6,6 +6,7 @@
 #include "FileDialog.h"
 #include "ImGui/imgui_impl_glfw.h"
 #include "ImGui/imgui_impl_opengl3.h"
+#include <filesystem>
 
 namespace Glitter
 {
@@ -48,10 +49,13 @@ namespace Glitter
 
 		void Application::setDirectory(const std::string& dir)
 		{
-			appDir = Glitter::File::getFilePath(dir);
-			shadersDir = appDir + "Res\\Shaders\\";
-			fontsDir = appDir + "Res\\Fonts\\";
-			screenshotsDir = appDir + "Screenshots\\";
+			// appending an empty element keeps the trailing separator callers concatenate file names onto
+			std::filesystem::path root = std::filesystem::path(dir).parent_path();
+			appDir = (root / "").string();
+			shadersDir = (root / "Res" / "Shaders" / "").string();
+			fontsDir = (root / "Res" / "Fonts" / "").string();
+			screenshotsDir = (root / "Screenshots" / "").string();
+			ModelCache::setDirectory((root / "Cache" / "").string());
 		}
 
 		std::string Application::getDirectory()
@@ -64,6 +68,11 @@ namespace Glitter
 			return screenshotsDir;
 		}
 
+		std::string Application::getShadersDirectory()
+		{
+			return shadersDir;
+		}
+
 		std::string Application::getAppVersion()
 		{
 			return version;
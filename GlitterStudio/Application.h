@@ -56,13 +56,15 @@ namespace Glitter
 			void about();
 			void processInput();
 			void updateUI();
-			void setDirectory(const std::string& dir);
 			void loadSettings(const std::string& filename);
 			void saveSettings(const std::string& filename);
 
+			static void setDirectory(const std::string& dir);
 			static std::string getAppVersion();
 			static std::string getDirectory();
 			static std::string getScreenshotsDirectory();
+			static std::string getShadersDirectory();
+			static void showError(const std::string& message);
 		};
 	}
 }
\ No newline at end of file
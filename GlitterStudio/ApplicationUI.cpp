@@ -3,6 +3,12 @@
 #include "IconsFontAwesome5.h"
 #include "CommandManager.h"
 #include "ResourceManager.h"
+#include "ParticleBudget.h"
+#include "TexturePacker.h"
+#include "IndexOptimizer.h"
+#include "MeshBVH.h"
+#include "MeshSkinner.h"
+#include "Logger.h"
 #include "FileDialog.h"
 #include "UI.h"
 
@@ -119,6 +125,69 @@ namespace Glitter
 				if (ImGui::TreeNodeEx("Performance", f | ImGuiTreeNodeFlags_DefaultOpen))
 				{
 					ImGui::Text("Frametime: %.3fms (%.2f FPS)", frameDelta * 1000, 1 / frameDelta);
+					ImGui::Text("Culled instances: %d", renderer->getNumCulled());
+					bool instancing = renderer->isInstancing();
+					if (ImGui::Checkbox("Instanced quads", &instancing))
+						renderer->setInstancing(instancing);
+
+					bool sorting = renderer->isSorting();
+					if (ImGui::Checkbox("Sort draws", &sorting))
+						renderer->setSorting(sorting);
+
+					ImGui::Text("Draw calls: %d", renderer->getNumDrawCalls());
+
+					bool depthSorting = renderer->isDepthSorting();
+					if (ImGui::Checkbox("Depth sort blended batches", &depthSorting))
+						renderer->setDepthSorting(depthSorting);
+
+					DepthSorter& sorter = renderer->getDepthSorter();
+					bool incremental = sorter.isIncremental();
+					if (ImGui::Checkbox("Incremental depth sort", &incremental))
+						sorter.setIncremental(incremental);
+
+					ImGui::Text("Depth sort: %.3fms (%zu quads)", sorter.getSortTime(), sorter.getSortedCount());
+					if (ImGui::Button("Benchmark depth sort"))
+						DepthSorter::benchmark();
+
+					ImGui::SameLine();
+					if (ImGui::Button("Benchmark index optimizer"))
+					{
+						for (const IndexBuildReport& report : IndexOptimizer::benchmark())
+							Logger::log(Message(MessageType::Normal, "index optimizer " + IndexOptimizer::formatReport(report)));
+					}
+
+					ImGui::SameLine();
+					if (ImGui::Button("Benchmark mesh BVH"))
+						MeshBVH::benchmark();
+
+					ImGui::SameLine();
+					if (ImGui::Button("Benchmark skinning"))
+						MeshSkinner::benchmark();
+
+					ImGui::Text("Texture arrays: %zu (%zu layers)", TexturePacker::getPageCount(), TexturePacker::getLayerCount());
+
+					ImGui::Text("Batch fill: %.3fms (%.1f KB uploaded, %zu bytes/vertex)", renderer->getFillTime(),
+						renderer->getUploadSize() / 1024.0f, sizeof(ParticleVertex));
+
+					ImGui::TreePop();
+				}
+
+				if (ImGui::TreeNodeEx("Particle Budget", f))
+				{
+					const BudgetStats& stats = ParticleBudget::getStats();
+					bool budgetEnabled = ParticleBudget::isEnabled();
+					int budget = ParticleBudget::getBudget();
+
+					if (ImGui::Checkbox("Enabled", &budgetEnabled))
+						ParticleBudget::setEnabled(budgetEnabled);
+
+					if (ImGui::DragInt("Budget", &budget, 100.0f, 0, 1000000))
+						ParticleBudget::setBudget(budget);
+
+					ImGui::Text("Live: %zu / %zu", stats.live, stats.budget);
+					ImGui::Text("Emission: %zu granted of %zu requested", stats.granted, stats.requested);
+					ImGui::Text("Throttled requests: %zu", stats.throttled);
+					ImGui::Text("Emitters sharing the budget: %zu", stats.requesters);
 
 					ImGui::TreePop();
 				}
@@ -9,12 +9,14 @@ namespace Glitter
 		std::stack<ICommand*> CommandManager::redoStack;
 
 		const size_t CommandManager::maxSize = 100;
+		size_t CommandManager::revision = 0;
 
 		void CommandManager::pushNew(ICommand* command)
 		{
 			command->execute();
 			undoStack.push(command);
 			clearRedo();
+			++revision;
 
 			Logger::log(Message(MessageType::Normal, command->getDescription()));
 		}
@@ -29,6 +31,7 @@ namespace Glitter
 
 			redoStack.push(command);
 			command->undo();
+			++revision;
 			Logger::log(Message(MessageType::Normal, "Undo " + std::string(command->getDescription())));
 		}
 
@@ -42,6 +45,7 @@ namespace Glitter
 
 			undoStack.push(command);
 			command->execute();
+			++revision;
 			Logger::log(Message(MessageType::Normal, "Redo " + std::string(command->getDescription())));
 		}
 
@@ -57,6 +61,11 @@ namespace Glitter
 			return "";
 		}
 
+		size_t CommandManager::getRevision()
+		{
+			return revision;
+		}
+
 		const char* CommandManager::peekRedo()
 		{
 			if (redoStack.empty())
@@ -13,6 +13,7 @@ namespace Glitter
 			static std::stack<ICommand*> redoStack;
 
 			static const size_t maxSize;
+			static size_t revision;
 
 		public:
 			static void pushNew(ICommand* command);
@@ -24,6 +25,7 @@ namespace Glitter
 			static void clean();
 			static const char* peekUndo();
 			static const char* peekRedo();
+			static size_t getRevision();
 
 			static std::stack<ICommand*> getUndoHistory() { return undoStack; }
 			static std::stack<ICommand*> getRedoHistory() { return redoStack; }
@@ -0,0 +1,212 @@
+#include "DepthSorter.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <random>
+
+// give up on refining once the previous order needs more shifting than this per element
+constexpr size_t maxRefineMovesPerElement = 4;
+
+DepthSorter::DepthSorter() :
+	slot{ 0 }, incremental{ false }, sortedCount{ 0 }, sortTime{ 0.0 }
+{
+}
+
+void DepthSorter::beginFrame()
+{
+	slot = 0;
+	sortedCount = 0;
+	sortTime = 0.0;
+}
+
+void DepthSorter::quantize(const std::vector<float>& depths)
+{
+	size_t count = depths.size();
+	keys.resize(count);
+
+	float minDepth = FLT_MAX;
+	float maxDepth = -FLT_MAX;
+	for (float d : depths)
+	{
+		minDepth = std::min(minDepth, d);
+		maxDepth = std::max(maxDepth, d);
+	}
+
+	// 16 bit keys relative to the batch's depth range take only two 8 bit passes
+	float range = maxDepth - minDepth;
+	float scale = range > 0.0f ? 65535.0f / range : 0.0f;
+	for (size_t i = 0; i < count; ++i)
+		keys[i] = (uint16_t)((depths[i] - minDepth) * scale);
+}
+
+void DepthSorter::radixSort(size_t count)
+{
+	order.resize(count);
+	scratch.resize(count);
+
+	size_t histogram[2][256]{};
+	for (size_t i = 0; i < count; ++i)
+	{
+		++histogram[0][keys[i] & 0xFF];
+		++histogram[1][keys[i] >> 8];
+	}
+
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		size_t sum = 0;
+		for (size_t b = 0; b < 256; ++b)
+		{
+			size_t c = histogram[pass][b];
+			histogram[pass][b] = sum;
+			sum += c;
+		}
+	}
+
+	// LSD passes are stable, so equal depths keep their submission order
+	for (size_t i = 0; i < count; ++i)
+		scratch[histogram[0][keys[i] & 0xFF]++] = i;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		uint32_t index = scratch[i];
+		order[histogram[1][keys[index] >> 8]++] = index;
+	}
+}
+
+bool DepthSorter::refine(std::vector<uint32_t>& previous, size_t count)
+{
+	if (previous.size() != count)
+		return false;
+
+	// insertion sort is close to linear when the order barely changed since the last frame
+	size_t moves = 0;
+	size_t maxMoves = count * maxRefineMovesPerElement;
+	for (size_t i = 1; i < count; ++i)
+	{
+		uint32_t index = previous[i];
+		uint16_t key = keys[index];
+
+		size_t j = i;
+		while (j > 0 && keys[previous[j - 1]] > key)
+		{
+			previous[j] = previous[j - 1];
+			--j;
+
+			if (++moves > maxMoves)
+				return false;
+		}
+
+		previous[j] = index;
+	}
+
+	order = previous;
+	return true;
+}
+
+const std::vector<uint32_t>& DepthSorter::sort(const std::vector<float>& depths)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	size_t count = depths.size();
+	quantize(depths);
+
+	if (!incremental)
+	{
+		radixSort(count);
+	}
+	else
+	{
+		if (history.size() <= slot)
+			history.resize(slot + 1);
+
+		std::vector<uint32_t>& previous = history[slot];
+		if (!refine(previous, count))
+		{
+			radixSort(count);
+			previous = order;
+		}
+	}
+
+	++slot;
+	sortedCount += count;
+	sortTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	return order;
+}
+
+void DepthSorter::setIncremental(bool enabled)
+{
+	incremental = enabled;
+	history.clear();
+}
+
+bool DepthSorter::isIncremental() const
+{
+	return incremental;
+}
+
+size_t DepthSorter::getSortedCount() const
+{
+	return sortedCount;
+}
+
+double DepthSorter::getSortTime() const
+{
+	return sortTime;
+}
+
+void DepthSorter::benchmark()
+{
+	using Clock = std::chrono::high_resolution_clock;
+	const size_t counts[] = { 10000, 25000, 50000, 100000 };
+	const int iterations = 20;
+
+	std::mt19937 engine(1234);
+	std::uniform_real_distribution<float> depthDist(-150.0f, -0.1f);
+	std::uniform_real_distribution<float> jitterDist(-0.01f, 0.01f);
+
+	for (size_t count : counts)
+	{
+		std::vector<float> depths(count);
+		for (float& d : depths)
+			d = depthDist(engine);
+
+		DepthSorter radix;
+		DepthSorter refined;
+		refined.setIncremental(true);
+		refined.sort(depths);
+
+		double radixTime = 0.0, refineTime = 0.0, stdTime = 0.0;
+		std::vector<uint32_t> stdOrder(count);
+		for (int i = 0; i < iterations; ++i)
+		{
+			// small per frame movement, like a camera orbiting the effect
+			for (float& d : depths)
+				d += jitterDist(engine);
+
+			auto t0 = Clock::now();
+			radix.beginFrame();
+			radix.sort(depths);
+
+			auto t1 = Clock::now();
+			refined.beginFrame();
+			refined.sort(depths);
+
+			auto t2 = Clock::now();
+			for (uint32_t j = 0; j < count; ++j)
+				stdOrder[j] = j;
+			std::stable_sort(stdOrder.begin(), stdOrder.end(), [&depths](uint32_t a, uint32_t b) { return depths[a] < depths[b]; });
+
+			auto t3 = Clock::now();
+			radixTime += std::chrono::duration<double, std::milli>(t1 - t0).count();
+			refineTime += std::chrono::duration<double, std::milli>(t2 - t1).count();
+			stdTime += std::chrono::duration<double, std::milli>(t3 - t2).count();
+		}
+
+		char msg[256];
+		snprintf(msg, sizeof(msg), "depth sort %zu particles: radix %.3fms, incremental %.3fms, std::stable_sort %.3fms",
+			count, radixTime / iterations, refineTime / iterations, stdTime / iterations);
+		Logger::log(Message(MessageType::Normal, msg));
+	}
+}
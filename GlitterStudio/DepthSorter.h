@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/// <summary>
+/// Orders batched particles back to front using a radix sort on quantized view depths.
+/// Buffers are kept between frames, and the previous order of each batch can be refined instead of sorted again.
+/// </summary>
+class DepthSorter
+{
+private:
+	std::vector<uint16_t> keys;
+	std::vector<uint32_t> order;
+	std::vector<uint32_t> scratch;
+	std::vector<std::vector<uint32_t>> history;
+	size_t slot;
+	bool incremental;
+	size_t sortedCount;
+	double sortTime;
+
+	void quantize(const std::vector<float>& depths);
+	void radixSort(size_t count);
+	bool refine(std::vector<uint32_t>& previous, size_t count);
+
+public:
+	DepthSorter();
+
+	void beginFrame();
+	const std::vector<uint32_t>& sort(const std::vector<float>& depths);
+
+	void setIncremental(bool enabled);
+	bool isIncremental() const;
+	size_t getSortedCount() const;
+	double getSortTime() const;
+
+	static void benchmark();
+};
@@ -5,7 +5,7 @@ namespace Glitter
 {
 	namespace Editor
 	{
-		EditorAnimationSet::EditorAnimationSet(std::vector<GlitterAnimation> list) : dirty{ true }
+		EditorAnimationSet::EditorAnimationSet(std::vector<GlitterAnimation> list) : revision{ 1 }
 		{
 			type = AnimationSetType::Glitter;
 			for (int i = 0; i < list.size(); ++i)
@@ -28,14 +28,14 @@ namespace Glitter
 				animations.erase(animations.begin() + pos);
 		}
 
-		bool EditorAnimationSet::isDirty() const
+		size_t EditorAnimationSet::getRevision() const
 		{
-			return dirty;
+			return revision;
 		}
 
-		void EditorAnimationSet::markDirty(bool v)
+		void EditorAnimationSet::markDirty()
 		{
-			dirty = v;
+			++revision;
 		}
 
 		float EditorAnimationSet::tryGetValue(AnimationType gType, float time, float fallback)
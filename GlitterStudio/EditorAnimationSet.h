@@ -19,7 +19,8 @@ namespace Glitter
 		class EditorAnimationSet
 		{
 		private:
-			bool dirty;
+			// bumped on every edit. caches built from the set compare it against the revision they were built from
+			size_t revision;
 
 		public:
 			AnimationSetType type;
@@ -31,8 +32,8 @@ namespace Glitter
 			void add(EditorAnimation animation, int pos);
 			void remove(int pos);
 
-			bool isDirty() const;
-			void markDirty(bool v);
+			size_t getRevision() const;
+			void markDirty();
 
 			float tryGetValue(Glitter::AnimationType gType, float time, float fallback = 0.0f);
 			Glitter::Vector3 tryGetTranslation(float time);
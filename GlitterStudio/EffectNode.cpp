@@ -10,7 +10,7 @@ namespace Glitter
 	namespace Editor
 	{
 		EffectNode::EffectNode(std::shared_ptr<GlitterEffect>& effect) :
-			effect{ effect }
+			effect{ effect }, animationRevision{ 0 }, priority{ BudgetPriority::Normal }, childLayout{ 0 }
 		{
 			animSet = std::make_shared<EditorAnimationSet>(effect->getAnimations());
 
@@ -20,10 +20,12 @@ namespace Glitter
 			for (auto& emitter : effect->getEmitters())
 				emitterNodes.emplace_back(std::make_shared<EmitterNode>(emitter, this));
 
-			animSet->markDirty(true);
+			prepareChildEmitters();
+			animSet->markDirty();
 		}
 
-		EffectNode::EffectNode(std::shared_ptr<EffectNode>& rhs)
+		EffectNode::EffectNode(std::shared_ptr<EffectNode>& rhs) :
+			animationRevision{ 0 }, priority{ rhs->priority }, childLayout{ 0 }
 		{
 			effect = std::make_shared<GlitterEffect>(*rhs->effect);
 			effect->setFilename("");
@@ -82,8 +84,9 @@ namespace Glitter
 				emitterNodes.push_back(eNode);
 			}
 
+			prepareChildEmitters();
 			animSet = std::make_shared<EditorAnimationSet>(effect->getAnimations());
-			animSet->markDirty(true);
+			animSet->markDirty();
 		}
 
 		std::shared_ptr<GlitterEffect> EffectNode::getEffect()
@@ -101,6 +104,16 @@ namespace Glitter
 			return particleNodes;
 		}
 
+		void EffectNode::setPriority(BudgetPriority val)
+		{
+			priority = val;
+		}
+
+		BudgetPriority EffectNode::getPriority() const
+		{
+			return priority;
+		}
+
 		std::shared_ptr<EditorAnimationSet> EffectNode::getAnimationSet()
 		{
 			return animSet;
@@ -119,15 +132,15 @@ namespace Glitter
 			mat4 *= DirectX::XMMatrixTranslation(pos.x, pos.y, pos.z);
 		}
 
-		void EffectNode::update(float time, const Camera& camera)
+		void EffectNode::update(float time, const Camera& camera, const ParticleCulling& culling)
 		{
 			float effectTime = time - effect->getStartTime();
 			float effectLife = fmodf(effectTime, effect->getLifeTime() + 1);
 
-			if (animSet->isDirty())
+			if (animationRevision != animSet->getRevision())
 			{
 				animationCache.buildCache(animSet);
-				animSet->markDirty(false);
+				animationRevision = animSet->getRevision();
 			}
 
 			// effect started playing
@@ -140,8 +153,95 @@ namespace Glitter
 
 				updateMatrix(position, qR, scale);
 
+				verifyChildEmitters();
+
+				// child emitters are only spawned by their parent particles
 				for (auto& emitter : emitterNodes)
-					emitter->update(effectTime, effectLife, camera, mat4, qR);
+				{
+					if (!emitter->isChildEmitter())
+						emitter->update(effectTime, effectLife, camera, culling, priority, mat4, qR);
+				}
+			}
+		}
+
+		size_t EffectNode::getChildLayout() const
+		{
+			// everything the child emitter pools are sized and linked from
+			size_t layout = emitterNodes.size();
+			auto combine = [&layout](size_t value) { layout ^= value + 0x9e3779b9 + (layout << 6) + (layout >> 2); };
+
+			for (auto& particleNode : particleNodes)
+			{
+				std::shared_ptr<Particle> particle = particleNode->getParticle();
+				combine(particle->getMaxCount());
+
+				std::vector<std::weak_ptr<Emitter>> children = particle->getChildEmitters();
+				combine(children.size());
+				for (auto& child : children)
+					combine((size_t)child.lock().get());
+			}
+
+			return layout;
+		}
+
+		void EffectNode::verifyChildEmitters()
+		{
+			if (getChildLayout() != childLayout)
+			{
+				prepareChildEmitters();
+				return;
+			}
+
+			// instances added since the last layout change, e.g. by adding a particle to an emitter
+			for (auto& emitter : emitterNodes)
+			{
+				if (emitter->isChildEmitter())
+					continue;
+
+				for (auto& particle : emitter->getParticles())
+				{
+					if (!particle.isChildEmittersPrepared())
+						particle.prepareChildEmitters(emitterNodes, 0);
+				}
+			}
+		}
+
+		void EffectNode::prepareChildEmitters()
+		{
+			childLayout = getChildLayout();
+			for (auto& emitter : emitterNodes)
+			{
+				emitter->setChildEmitter(false);
+
+				// pools from the previous layout may have the wrong capacity or point at removed emitters
+				for (auto& particle : emitter->getParticles())
+				{
+					particle.killChildEmitters();
+					particle.clearChildEmitters();
+				}
+			}
+
+			for (auto& particleNode : particleNodes)
+			{
+				for (auto& child : particleNode->getParticle()->getChildEmitters())
+				{
+					std::shared_ptr<Emitter> childEmitter = child.lock();
+					for (auto& emitter : emitterNodes)
+					{
+						if (emitter->getEmitter() == childEmitter)
+							emitter->setChildEmitter(true);
+					}
+				}
+			}
+
+			// pools are allocated here, outside of the frame loop
+			for (auto& emitter : emitterNodes)
+			{
+				if (emitter->isChildEmitter())
+					continue;
+
+				for (auto& particle : emitter->getParticles())
+					particle.prepareChildEmitters(emitterNodes, 0);
 			}
 		}
 
@@ -151,6 +251,29 @@ namespace Glitter
 				emitter->kill();
 		}
 
+		EffectState EffectNode::saveState() const
+		{
+			EffectState state;
+			state.emitters.reserve(emitterNodes.size());
+
+			for (const auto& emitter : emitterNodes)
+				state.emitters.emplace_back(emitter->saveState());
+
+			return state;
+		}
+
+		bool EffectNode::restoreState(const EffectState& state)
+		{
+			// emitters may have been added or removed since the state was saved
+			if (state.emitters.size() != emitterNodes.size())
+				return false;
+
+			for (size_t i = 0; i < emitterNodes.size(); ++i)
+				emitterNodes[i]->restoreState(state.emitters[i]);
+
+			return true;
+		}
+
 		void EffectNode::save(const std::string& filename)
 		{
 			// write animations
@@ -3,11 +3,17 @@
 #include "EmitterNode.h"
 #include "ParticleNode.h"
 #include "GlitterEffect.h"
+#include "ParticleBudget.h"
 
 namespace Glitter
 {
 	namespace Editor
 	{
+		struct EffectState
+		{
+			std::vector<EmitterState> emitters;
+		};
+
 		class EffectNode : public INode
 		{
 		private:
@@ -17,8 +23,13 @@ namespace Glitter
 			std::vector<std::shared_ptr<ParticleNode>> particleNodes;
 			DirectX::XMMATRIX mat4;
 			CachedAnimation animationCache;
+			size_t animationRevision;
+			BudgetPriority priority;
+			size_t childLayout;
 
 			void updateMatrix(const Vector3& pos, const Quaternion& rot, const Vector3& scale);
+			size_t getChildLayout() const;
+			void prepareChildEmitters();
 
 		public:
 			EffectNode(std::shared_ptr<GlitterEffect>& eff);
@@ -28,8 +39,13 @@ namespace Glitter
 			std::vector<std::shared_ptr<EmitterNode>>& getEmitterNodes();
 			std::vector<std::shared_ptr<ParticleNode>>& getParticleNodes();
 
-			void update(float time, const Camera& camera);
+			void update(float time, const Camera& camera, const ParticleCulling& culling);
+			void verifyChildEmitters();
+			void setPriority(BudgetPriority val);
+			BudgetPriority getPriority() const;
 			void kill();
+			EffectState saveState() const;
+			bool restoreState(const EffectState& state);
 			void save(const std::string& filename);
 
 			virtual NodeType getNodeType() override;
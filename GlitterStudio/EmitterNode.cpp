@@ -12,7 +12,7 @@ namespace Glitter
 	namespace Editor
 	{
 		EmitterNode::EmitterNode(std::shared_ptr<Emitter>& em, EffectNode* eff) :
-			emitter{ em }, lastEmissionTime{ -1 }, lastRotIncrement{ -1 }, visible{ true }
+			emitter{ em }, animationRevision{ 0 }, lastEmissionTime{ -1 }, lastRotIncrement{ -1 }, visible{ true }, culled{ false }, childEmitter{ false }
 		{
 			animSet = std::make_shared<EditorAnimationSet>(em->getAnimations());
 
@@ -35,10 +35,10 @@ namespace Glitter
 				changeMesh(ResourceManager::getModel(em->getMeshName() + ".model"));
 			}
 
-			animSet->markDirty(true);
+			animSet->markDirty();
 		}
 
-		EmitterNode::EmitterNode(std::shared_ptr<EmitterNode>& rhs)
+		EmitterNode::EmitterNode(std::shared_ptr<EmitterNode>& rhs) : animationRevision{ 0 }, culled{ false }, childEmitter{ false }
 		{
 			emitter = std::make_shared<Emitter>(*rhs->emitter);
 			animSet = std::make_shared<EditorAnimationSet>(*rhs->animSet);
@@ -46,7 +46,28 @@ namespace Glitter
 			particleInstances = rhs->particleInstances;
 			mesh = std::shared_ptr<ModelData>(rhs->mesh);
 
-			animSet->markDirty(true);
+			// child emitter pools belong to the source. the effect prepares new ones
+			for (auto& particle : particleInstances)
+				particle.clearChildEmitters();
+
+			animSet->markDirty();
+		}
+
+		EmitterNode::EmitterNode(const EmitterNode& source, const std::vector<std::shared_ptr<EmitterNode>>& emitters, int depth) :
+			emitter{ source.emitter }, animSet{ source.animSet }, mesh{ source.mesh }, lastEmissionTime{ -1 }, lastRotIncrement{ -1 },
+			visible{ true }, culled{ false }, childEmitter{ false }, emissionCount{ 0 }, emissionInterval{ 0.0f }
+		{
+			// pooled instance of a child emitter. shares the source's emitter and animations but simulates its own particles
+			mat4 = DirectX::XMMatrixIdentity();
+			animationCache.buildCache(animSet);
+			animationRevision = animSet->getRevision();
+
+			particleInstances.reserve(source.particleInstances.size());
+			for (const ParticleInstance& particle : source.particleInstances)
+			{
+				particleInstances.emplace_back(particle.getReference());
+				particleInstances.back().prepareChildEmitters(emitters, depth);
+			}
 		}
 
 		std::vector<ParticleInstance>& EmitterNode::getParticles()
@@ -80,6 +101,42 @@ namespace Glitter
 			return visible;
 		}
 
+		bool EmitterNode::isCulled() const
+		{
+			return culled;
+		}
+
+		bool EmitterNode::isAlive() const
+		{
+			for (const ParticleInstance& particle : particleInstances)
+			{
+				if (particle.getAliveCount() || particle.hasActiveChildEmitters())
+					return true;
+			}
+
+			return false;
+		}
+
+		bool EmitterNode::isChildEmitter() const
+		{
+			return childEmitter;
+		}
+
+		void EmitterNode::setChildEmitter(bool val)
+		{
+			childEmitter = val;
+		}
+
+		void EmitterNode::setCulled(bool val)
+		{
+			culled = val;
+		}
+
+		const DirectX::BoundingBox& EmitterNode::getBounds() const
+		{
+			return bounds;
+		}
+
 		void EmitterNode::setVisible(bool val)
 		{
 			visible = val;
@@ -101,7 +158,7 @@ namespace Glitter
 
 		void EmitterNode::emit(float time, int count)
 		{
-			if (!emissionCount)
+			if (!emissionCount || count <= 0)
 				return;
 
 			std::vector<Vector3> basePositions;
@@ -115,6 +172,8 @@ namespace Glitter
 
 			for (auto& particle : particleInstances)
 			{
+				// each instance spawns from its own positions
+				basePositions.clear();
 				for (int i = 0; i < count; ++i)
 				{
 					if (emitter->getType() == EmitterType::Box)
@@ -244,7 +303,21 @@ namespace Glitter
 			mat4 *= DirectX::XMMatrixTranslationFromVector(emPos);
 		}
 
-		void EmitterNode::update(float time, float effTime, const Camera& camera, const DirectX::XMMATRIX &effM4, const Quaternion &effRot)
+		int EmitterNode::requestEmission(BudgetPriority priority, float distance)
+		{
+			// every particle instance receives the full emission count
+			int instanceCount = particleInstances.size();
+			if (!emissionCount || !instanceCount)
+				return emissionCount;
+
+			int granted = ParticleBudget::request(this, emissionCount * instanceCount, priority, distance);
+			int count = granted / instanceCount;
+			ParticleBudget::release(granted - count * instanceCount);
+
+			return count;
+		}
+
+		void EmitterNode::update(float time, float effTime, const Camera& camera, const ParticleCulling& culling, BudgetPriority priority, const DirectX::XMMATRIX &effM4, const Quaternion &effRot)
 		{
 			float emitterTime = time - emitter->getStartTime();
 			float emitterLife = fmodf(emitterTime, emitter->getLifeTime() + 1);
@@ -261,10 +334,10 @@ namespace Glitter
 				lastRotIncrement = (int)emitterTime;
 			}
 
-			if (animSet->isDirty())
+			if (animationRevision != animSet->getRevision())
 			{
 				animationCache.buildCache(animSet);
-				animSet->markDirty(false);
+				animationRevision = animSet->getRevision();
 			}
 
 			Quaternion qR;
@@ -283,6 +356,11 @@ namespace Glitter
 				if (count > -1)
 					emissionCount = count;
 
+				// distance LOD. keep at least one particle per emission so sparse emitters don't vanish
+				float lodScale = culling.getEmissionScale(mat4.r[3]);
+				if (emissionCount && lodScale < 1.0f)
+					emissionCount = std::max(1, (int)ceilf(emissionCount * lodScale));
+
 				// return -1 if no interval animation is applied since the animation can have a value of 0.
 				emissionInterval = emitter->getEmissionInterval();
 				float interval = animationCache.getValue(AnimationType::EmissionInterval, emitterLife, -1.0f);
@@ -296,7 +374,11 @@ namespace Glitter
 						if ((fmodf(emissionTime, emissionInterval) <= 0.1f || emissionTime == 0) && ((int)emissionTime != (int)lastEmissionTime))
 						{
 							lastEmissionTime = (int)emissionTime;
-							emit(emitterTime, emissionCount);
+
+							// a throttled emission spawns nothing
+							int count = requestEmission(priority, culling.getDistance(mat4.r[3]));
+							if (count > 0)
+								emit(emitterTime, count);
 						}
 					}
 					else
@@ -304,15 +386,40 @@ namespace Glitter
 						float delta = translation.distance(lastEmissionPosition);
 						if ((fmodf(delta, emissionInterval) <= 0.1f) && (lastEmissionPosition != translation))
 						{
-							emit(emitterTime, emissionCount);
+							int count = requestEmission(priority, culling.getDistance(mat4.r[3]));
+							if (count > 0)
+								emit(emitterTime, count);
+
 							lastEmissionPosition = translation;
 						}
 					}
 				}
 			}
 
+			culled = true;
 			for (auto& particle : particleInstances)
-				particle.update(emitterTime, camera, mat4, qR);
+			{
+				particle.update(emitterTime, camera, culling, mat4, qR);
+				particle.updateChildEmitters(emitterTime, camera, culling, priority, qR);
+				ParticleBudget::report(particle.getAliveCount());
+				if (particle.isCulled())
+					continue;
+
+				if (culled)
+					bounds = particle.getBounds();
+				else
+					DirectX::BoundingBox::CreateMerged(bounds, bounds, particle.getBounds());
+
+				culled = false;
+			}
+		}
+
+		void EmitterNode::resetEmission()
+		{
+			lastEmissionTime = -1;
+			lastRotIncrement = -1;
+			lastEmissionPosition = Vector3();
+			rotationAdd = Vector3();
 		}
 
 		void EmitterNode::kill()
@@ -321,6 +428,33 @@ namespace Glitter
 				particle.kill();
 		}
 
+		EmitterState EmitterNode::saveState() const
+		{
+			EmitterState state;
+			state.lastEmissionTime = lastEmissionTime;
+			state.lastRotIncrement = lastRotIncrement;
+			state.lastEmissionPosition = lastEmissionPosition;
+			state.rotationAdd = rotationAdd;
+
+			state.particles.reserve(particleInstances.size());
+			for (const ParticleInstance& particle : particleInstances)
+				state.particles.emplace_back(particle.saveState());
+
+			return state;
+		}
+
+		void EmitterNode::restoreState(const EmitterState& state)
+		{
+			lastEmissionTime = state.lastEmissionTime;
+			lastRotIncrement = state.lastRotIncrement;
+			lastEmissionPosition = state.lastEmissionPosition;
+			rotationAdd = state.rotationAdd;
+			culled = false;
+
+			for (size_t i = 0; i < particleInstances.size() && i < state.particles.size(); ++i)
+				particleInstances[i].restoreState(state.particles[i]);
+		}
+
 		NodeType EmitterNode::getNodeType()
 		{
 			return NodeType::Emitter;
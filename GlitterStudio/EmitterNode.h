@@ -5,6 +5,7 @@
 #include "ParticleInstance.h"
 #include "ModelData.h"
 #include "CachedAnimation.h"
+#include "ParticleBudget.h"
 
 namespace Glitter
 {
@@ -12,6 +13,15 @@ namespace Glitter
 	{
 		class EffectNode;
 
+		struct EmitterState
+		{
+			float lastEmissionTime;
+			float lastRotIncrement;
+			Vector3 lastEmissionPosition;
+			Vector3 rotationAdd;
+			std::vector<ParticleInstanceState> particles;
+		};
+
 		class EmitterNode : public INode
 		{
 		private:
@@ -19,10 +29,14 @@ namespace Glitter
 			std::shared_ptr<EditorAnimationSet> animSet;
 			DirectX::XMMATRIX mat4;
 			CachedAnimation animationCache;
+			size_t animationRevision;
 			std::shared_ptr<ModelData> mesh;
 			std::vector<ParticleInstance> particleInstances;
 
 			bool visible;
+			bool culled;
+			bool childEmitter;
+			DirectX::BoundingBox bounds;
 			int emissionCount;
 			float emissionInterval;
 			float lastEmissionTime;
@@ -30,12 +44,14 @@ namespace Glitter
 			Vector3 lastEmissionPosition;
 			Vector3 rotationAdd;
 
+			int requestEmission(BudgetPriority priority, float distance);
 			void updateMatrix(const Vector3& pos, const Quaternion& rot, const Vector3& scale, 
 				const Camera &view, const DirectX::XMMATRIX &effMat);
 
 		public:
 			EmitterNode(std::shared_ptr<Emitter>& em, EffectNode* parent);
 			EmitterNode(std::shared_ptr<EmitterNode>& rhs);
+			EmitterNode(const EmitterNode& source, const std::vector<std::shared_ptr<EmitterNode>>& emitters, int depth);
 
 			std::shared_ptr<Emitter> getEmitter();
 			std::vector<ParticleInstance>& getParticles();
@@ -44,14 +60,23 @@ namespace Glitter
 			virtual void populateInspector() override;
 			virtual std::shared_ptr<EditorAnimationSet> getAnimationSet() override;
 
-			void update(float time, float effTime, const Camera& camera, const DirectX::XMMATRIX &effM4, const Quaternion &effRot);
+			void update(float time, float effTime, const Camera& camera, const ParticleCulling& culling, BudgetPriority priority, const DirectX::XMMATRIX &effM4, const Quaternion &effRot);
 			void emit(float time, int count);
+			void resetEmission();
 			void kill();
+			EmitterState saveState() const;
+			void restoreState(const EmitterState& state);
 			void changeMesh(std::shared_ptr<ModelData> mesh);
 			void save();
 			void setVisible(bool val);
 			void setVisibleAll(bool val);
 			bool isVisible() const;
+			bool isCulled() const;
+			bool isAlive() const;
+			bool isChildEmitter() const;
+			void setChildEmitter(bool val);
+			void setCulled(bool val);
+			const DirectX::BoundingBox& getBounds() const;
 
 			std::shared_ptr<ModelData> getMesh() const;
 		};
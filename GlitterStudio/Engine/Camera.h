@@ -51,6 +51,7 @@ public:
 	inline float getYaw() const { return yaw; }
 	inline float getPitch() const { return pitch; }
 	inline float getDistance() const { return radius; }
+	inline DirectX::XMVECTOR getPosition() const { return position; }
 
 	DirectX::XMMATRIX getViewMatrix() const;
 	DirectX::XMMATRIX getProjectionMatrix(float aspect) const;
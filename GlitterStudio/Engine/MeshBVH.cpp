@@ -0,0 +1,628 @@
+#include "MeshBVH.h"
+#include "SubmeshData.h"
+#include "../Logger.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+using namespace DirectX;
+
+static_assert(sizeof(BVHNode) == 32, "two nodes share a cache line");
+
+constexpr int bvhBinCount = 16;
+constexpr uint32_t bvhLeafSize = 4;
+constexpr uint32_t bvhMaxLeafSize = 16;
+constexpr uint32_t bvhStackSize = 64;
+
+struct BVHBounds
+{
+	XMVECTOR min;
+	XMVECTOR max;
+
+	BVHBounds() : min{ XMVectorReplicate(FLT_MAX) }, max{ XMVectorReplicate(-FLT_MAX) }
+	{
+	}
+
+	void grow(FXMVECTOR point)
+	{
+		min = XMVectorMin(min, point);
+		max = XMVectorMax(max, point);
+	}
+
+	void grow(const BVHBounds& other)
+	{
+		min = XMVectorMin(min, other.min);
+		max = XMVectorMax(max, other.max);
+	}
+
+	float area() const
+	{
+		XMFLOAT3 e;
+		XMStoreFloat3(&e, XMVectorMax(XMVectorSubtract(max, min), XMVectorZero()));
+		return e.x * e.y + e.y * e.z + e.z * e.x;
+	}
+};
+
+// distance along the ray to where it enters the node, or FLT_MAX if it misses or enters past maxDistance
+static float intersectNode(const BVHNode& node, FXMVECTOR origin, FXMVECTOR invDirection, float maxDistance)
+{
+	XMVECTOR t0 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&node.min), origin), invDirection);
+	XMVECTOR t1 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&node.max), origin), invDirection);
+	XMVECTOR tNear = XMVectorMin(t0, t1);
+	XMVECTOR tFar = XMVectorMax(t0, t1);
+
+	float enter = std::max(std::max(XMVectorGetX(tNear), XMVectorGetY(tNear)), std::max(XMVectorGetZ(tNear), 0.0f));
+	float exit = std::min(std::min(XMVectorGetX(tFar), XMVectorGetY(tFar)), std::min(XMVectorGetZ(tFar), maxDistance));
+
+	return enter <= exit ? enter : FLT_MAX;
+}
+
+static float nodeDistanceSq(const BVHNode& node, FXMVECTOR point)
+{
+	XMVECTOR outside = XMVectorMax(XMVectorSubtract(XMLoadFloat3(&node.min), point), XMVectorSubtract(point, XMLoadFloat3(&node.max)));
+	return XMVectorGetX(XMVector3LengthSq(XMVectorMax(outside, XMVectorZero())));
+}
+
+// Moller-Trumbore. u and v weigh the second and third vertex
+static bool intersectTriangle(FXMVECTOR origin, FXMVECTOR direction, FXMVECTOR v0, GXMVECTOR v1, HXMVECTOR v2, float& t, float& u, float& v)
+{
+	XMVECTOR e1 = XMVectorSubtract(v1, v0);
+	XMVECTOR e2 = XMVectorSubtract(v2, v0);
+	XMVECTOR p = XMVector3Cross(direction, e2);
+	float det = XMVectorGetX(XMVector3Dot(e1, p));
+	if (std::fabs(det) < 1e-12f)
+		return false;
+
+	float invDet = 1.0f / det;
+	XMVECTOR s = XMVectorSubtract(origin, v0);
+	u = XMVectorGetX(XMVector3Dot(s, p)) * invDet;
+	if (u < 0.0f || u > 1.0f)
+		return false;
+
+	XMVECTOR q = XMVector3Cross(s, e1);
+	v = XMVectorGetX(XMVector3Dot(direction, q)) * invDet;
+	if (v < 0.0f || u + v > 1.0f)
+		return false;
+
+	t = XMVectorGetX(XMVector3Dot(e2, q)) * invDet;
+	return t >= 0.0f;
+}
+
+// Ericson, Real-Time Collision Detection 5.1.5
+static void closestOnTriangle(FXMVECTOR p, FXMVECTOR a, FXMVECTOR b, GXMVECTOR c, float& u, float& v)
+{
+	XMVECTOR ab = XMVectorSubtract(b, a);
+	XMVECTOR ac = XMVectorSubtract(c, a);
+	XMVECTOR ap = XMVectorSubtract(p, a);
+	float d1 = XMVectorGetX(XMVector3Dot(ab, ap));
+	float d2 = XMVectorGetX(XMVector3Dot(ac, ap));
+	if (d1 <= 0.0f && d2 <= 0.0f)
+	{
+		u = 0.0f; v = 0.0f;
+		return;
+	}
+
+	XMVECTOR bp = XMVectorSubtract(p, b);
+	float d3 = XMVectorGetX(XMVector3Dot(ab, bp));
+	float d4 = XMVectorGetX(XMVector3Dot(ac, bp));
+	if (d3 >= 0.0f && d4 <= d3)
+	{
+		u = 1.0f; v = 0.0f;
+		return;
+	}
+
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+	{
+		u = d1 / (d1 - d3); v = 0.0f;
+		return;
+	}
+
+	XMVECTOR cp = XMVectorSubtract(p, c);
+	float d5 = XMVectorGetX(XMVector3Dot(ab, cp));
+	float d6 = XMVectorGetX(XMVector3Dot(ac, cp));
+	if (d6 >= 0.0f && d5 <= d6)
+	{
+		u = 0.0f; v = 1.0f;
+		return;
+	}
+
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+	{
+		u = 0.0f; v = d2 / (d2 - d6);
+		return;
+	}
+
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+	{
+		float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		u = 1.0f - w; v = w;
+		return;
+	}
+
+	float denom = 1.0f / (va + vb + vc);
+	u = vb * denom;
+	v = vc * denom;
+}
+
+MeshBVH::MeshBVH() : depth{ 0 }, buildTime{ 0.0 }
+{
+}
+
+void MeshBVH::build(const std::vector<VertexData>& vertices, const std::vector<unsigned int>& indices)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	clear();
+
+	size_t triangleCount = indices.size() / 3;
+	if (!triangleCount)
+		return;
+
+	std::vector<BVHBounds> bounds(triangleCount);
+	std::vector<XMVECTOR> centroids(triangleCount);
+	std::vector<uint32_t> order(triangleCount);
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			const Glitter::Vector3& p = vertices[indices[t * 3 + corner]].position;
+			bounds[t].grow(XMVectorSet(p.x, p.y, p.z, 0.0f));
+		}
+
+		centroids[t] = XMVectorScale(XMVectorAdd(bounds[t].min, bounds[t].max), 0.5f);
+		order[t] = t;
+	}
+
+	struct BuildTask
+	{
+		uint32_t node;
+		uint32_t begin;
+		uint32_t end;
+		uint32_t depth;
+	};
+
+	nodes.reserve(triangleCount * 2 / bvhLeafSize + 1);
+	nodes.emplace_back();
+
+	std::vector<BuildTask> tasks;
+	tasks.push_back({ 0, 0, (uint32_t)triangleCount, 0 });
+
+	while (tasks.size())
+	{
+		BuildTask task = tasks.back();
+		tasks.pop_back();
+		depth = std::max(depth, task.depth);
+
+		BVHBounds nodeBounds, centroidBounds;
+		for (uint32_t i = task.begin; i < task.end; ++i)
+		{
+			nodeBounds.grow(bounds[order[i]]);
+			centroidBounds.grow(centroids[order[i]]);
+		}
+
+		BVHNode& node = nodes[task.node];
+		XMStoreFloat3(&node.min, nodeBounds.min);
+		XMStoreFloat3(&node.max, nodeBounds.max);
+		node.first = task.begin;
+		node.count = task.end - task.begin;
+
+		if (node.count <= bvhLeafSize)
+			continue;
+
+		// binned SAH over the centroid bounds
+		XMFLOAT3 cMin, cMax;
+		XMStoreFloat3(&cMin, centroidBounds.min);
+		XMStoreFloat3(&cMax, centroidBounds.max);
+		const float* lo = &cMin.x;
+		const float* hi = &cMax.x;
+
+		float bestCost = FLT_MAX;
+		int bestAxis = -1;
+		int bestBin = 0;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			float extent = hi[axis] - lo[axis];
+			if (extent <= 0.0f)
+				continue;
+
+			BVHBounds binBounds[bvhBinCount];
+			uint32_t binCounts[bvhBinCount] = {};
+			float scale = bvhBinCount / extent;
+
+			for (uint32_t i = task.begin; i < task.end; ++i)
+			{
+				float c = XMVectorGetByIndex(centroids[order[i]], axis);
+				int bin = std::min((int)((c - lo[axis]) * scale), bvhBinCount - 1);
+				binBounds[bin].grow(bounds[order[i]]);
+				binCounts[bin]++;
+			}
+
+			float leftArea[bvhBinCount - 1];
+			uint32_t leftCount[bvhBinCount - 1];
+			BVHBounds left;
+			uint32_t count = 0;
+			for (int b = 0; b < bvhBinCount - 1; ++b)
+			{
+				left.grow(binBounds[b]);
+				count += binCounts[b];
+				leftArea[b] = left.area();
+				leftCount[b] = count;
+			}
+
+			BVHBounds right;
+			count = 0;
+			for (int b = bvhBinCount - 1; b > 0; --b)
+			{
+				right.grow(binBounds[b]);
+				count += binCounts[b];
+
+				float cost = leftCount[b - 1] * leftArea[b - 1] + count * right.area();
+				if (leftCount[b - 1] && count && cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestBin = b;
+				}
+			}
+		}
+
+		// a split has to beat intersecting every triangle in the node, unless the leaf would be too large
+		float leafCost = node.count * nodeBounds.area();
+		if (node.count <= bvhMaxLeafSize && (bestAxis < 0 || bestCost + nodeBounds.area() >= leafCost))
+			continue;
+
+		uint32_t mid;
+		if (bestAxis >= 0)
+		{
+			float scale = bvhBinCount / (hi[bestAxis] - lo[bestAxis]);
+			float base = lo[bestAxis];
+			int axis = bestAxis;
+			int bin = bestBin;
+			mid = (uint32_t)(std::partition(order.begin() + task.begin, order.begin() + task.end, [&](uint32_t t)
+			{
+				return std::min((int)((XMVectorGetByIndex(centroids[t], axis) - base) * scale), bvhBinCount - 1) < bin;
+			}) - order.begin());
+		}
+		else
+		{
+			// every centroid in the same place, any split is as good as another
+			mid = task.begin + node.count / 2;
+		}
+
+		uint32_t left = (uint32_t)nodes.size();
+		node.first = left;
+		node.count = 0;
+		nodes.emplace_back();
+		nodes.emplace_back();
+
+		tasks.push_back({ left, task.begin, mid, task.depth + 1 });
+		tasks.push_back({ left + 1, mid, task.end, task.depth + 1 });
+	}
+
+	// store triangles in leaf order, so leaves read them sequentially
+	positions.resize(triangleCount * 3);
+	areas.resize(triangleCount);
+	triangleIds = std::move(order);
+
+	double totalArea = 0.0;
+	for (size_t i = 0; i < triangleCount; ++i)
+	{
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			const Glitter::Vector3& p = vertices[indices[triangleIds[i] * 3 + corner]].position;
+			positions[i * 3 + corner] = XMFLOAT3(p.x, p.y, p.z);
+		}
+
+		XMVECTOR v0 = XMLoadFloat3(&positions[i * 3]);
+		XMVECTOR cross = XMVector3Cross(XMVectorSubtract(XMLoadFloat3(&positions[i * 3 + 1]), v0), XMVectorSubtract(XMLoadFloat3(&positions[i * 3 + 2]), v0));
+		totalArea += XMVectorGetX(XMVector3Length(cross)) * 0.5f;
+		areas[i] = totalArea;
+	}
+
+	nodes.shrink_to_fit();
+	buildTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void MeshBVH::clear()
+{
+	nodes.clear();
+	positions.clear();
+	triangleIds.clear();
+	areas.clear();
+	depth = 0;
+	buildTime = 0.0;
+}
+
+bool MeshBVH::empty() const
+{
+	return nodes.empty();
+}
+
+void MeshBVH::fillHit(uint32_t triangle, float u, float v, BVHHit& hit) const
+{
+	XMVECTOR v0 = XMLoadFloat3(&positions[triangle * 3]);
+	XMVECTOR e1 = XMVectorSubtract(XMLoadFloat3(&positions[triangle * 3 + 1]), v0);
+	XMVECTOR e2 = XMVectorSubtract(XMLoadFloat3(&positions[triangle * 3 + 2]), v0);
+
+	hit.triangle = triangleIds[triangle];
+	hit.u = u;
+	hit.v = v;
+	XMStoreFloat3(&hit.position, XMVectorAdd(v0, XMVectorAdd(XMVectorScale(e1, u), XMVectorScale(e2, v))));
+	XMStoreFloat3(&hit.normal, XMVector3Normalize(XMVector3Cross(e1, e2)));
+}
+
+bool MeshBVH::rayCast(FXMVECTOR origin, FXMVECTOR direction, float maxDistance, BVHHit& hit) const
+{
+	if (nodes.empty())
+		return false;
+
+	// distances are measured along the normalized direction
+	XMVECTOR dir = XMVector3Normalize(direction);
+	XMVECTOR invDir = XMVectorReciprocal(dir);
+
+	float closest = maxDistance;
+	uint32_t hitTriangle = UINT32_MAX;
+	float hitU = 0.0f, hitV = 0.0f;
+
+	if (intersectNode(nodes[0], origin, invDir, closest) == FLT_MAX)
+		return false;
+
+	// a traversal holds at most one sibling per level besides the node it pops, deep trees get their stack from the heap
+	uint32_t localStack[bvhStackSize];
+	std::vector<uint32_t> heapStack;
+	uint32_t* stack = localStack;
+	if (depth >= bvhStackSize)
+	{
+		heapStack.resize(depth + 1);
+		stack = heapStack.data();
+	}
+
+	uint32_t top = 0;
+	stack[top++] = 0;
+
+	while (top)
+	{
+		const BVHNode& node = nodes[stack[--top]];
+
+		if (node.count)
+		{
+			for (uint32_t t = node.first; t < node.first + node.count; ++t)
+			{
+				float distance, u, v;
+				if (intersectTriangle(origin, dir, XMLoadFloat3(&positions[t * 3]), XMLoadFloat3(&positions[t * 3 + 1]), XMLoadFloat3(&positions[t * 3 + 2]), distance, u, v) &&
+					distance < closest)
+				{
+					closest = distance;
+					hitTriangle = t;
+					hitU = u;
+					hitV = v;
+				}
+			}
+
+			continue;
+		}
+
+		uint32_t firstChild = node.first;
+		uint32_t secondChild = node.first + 1;
+		float firstDistance = intersectNode(nodes[firstChild], origin, invDir, closest);
+		float secondDistance = intersectNode(nodes[secondChild], origin, invDir, closest);
+		if (secondDistance < firstDistance)
+		{
+			std::swap(firstChild, secondChild);
+			std::swap(firstDistance, secondDistance);
+		}
+
+		// nearer child is popped first, so it can shorten the ray before the other is tested
+		if (secondDistance != FLT_MAX)
+			stack[top++] = secondChild;
+
+		if (firstDistance != FLT_MAX)
+			stack[top++] = firstChild;
+	}
+
+	if (hitTriangle == UINT32_MAX)
+		return false;
+
+	fillHit(hitTriangle, hitU, hitV, hit);
+	hit.distance = closest;
+	return true;
+}
+
+bool MeshBVH::closestPoint(FXMVECTOR point, float maxDistance, BVHHit& hit) const
+{
+	if (nodes.empty())
+		return false;
+
+	float closestSq = maxDistance * maxDistance;
+	uint32_t hitTriangle = UINT32_MAX;
+	float hitU = 0.0f, hitV = 0.0f;
+
+	if (nodeDistanceSq(nodes[0], point) > closestSq)
+		return false;
+
+	uint32_t localStack[bvhStackSize];
+	std::vector<uint32_t> heapStack;
+	uint32_t* stack = localStack;
+	if (depth >= bvhStackSize)
+	{
+		heapStack.resize(depth + 1);
+		stack = heapStack.data();
+	}
+
+	uint32_t top = 0;
+	stack[top++] = 0;
+
+	while (top)
+	{
+		const BVHNode& node = nodes[stack[--top]];
+		if (nodeDistanceSq(node, point) > closestSq)
+			continue;
+
+		if (node.count)
+		{
+			for (uint32_t t = node.first; t < node.first + node.count; ++t)
+			{
+				XMVECTOR v0 = XMLoadFloat3(&positions[t * 3]);
+				XMVECTOR v1 = XMLoadFloat3(&positions[t * 3 + 1]);
+				XMVECTOR v2 = XMLoadFloat3(&positions[t * 3 + 2]);
+
+				float u, v;
+				closestOnTriangle(point, v0, v1, v2, u, v);
+
+				XMVECTOR p = XMVectorAdd(v0, XMVectorAdd(XMVectorScale(XMVectorSubtract(v1, v0), u), XMVectorScale(XMVectorSubtract(v2, v0), v)));
+				float distanceSq = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(p, point)));
+				if (distanceSq <= closestSq)
+				{
+					closestSq = distanceSq;
+					hitTriangle = t;
+					hitU = u;
+					hitV = v;
+				}
+			}
+
+			continue;
+		}
+
+		uint32_t firstChild = node.first;
+		uint32_t secondChild = node.first + 1;
+		float firstDistance = nodeDistanceSq(nodes[firstChild], point);
+		float secondDistance = nodeDistanceSq(nodes[secondChild], point);
+		if (secondDistance < firstDistance)
+		{
+			std::swap(firstChild, secondChild);
+			std::swap(firstDistance, secondDistance);
+		}
+
+		if (secondDistance <= closestSq)
+			stack[top++] = secondChild;
+
+		if (firstDistance <= closestSq)
+			stack[top++] = firstChild;
+	}
+
+	if (hitTriangle == UINT32_MAX)
+		return false;
+
+	fillHit(hitTriangle, hitU, hitV, hit);
+	hit.distance = std::sqrt(closestSq);
+	return true;
+}
+
+bool MeshBVH::sampleSurface(float r0, float r1, float r2, BVHHit& sample) const
+{
+	if (areas.empty() || areas.back() <= 0.0)
+		return false;
+
+	// pick a triangle weighted by area, then a uniform point inside it
+	double target = r0 * areas.back();
+	size_t triangle = std::upper_bound(areas.begin(), areas.end(), target) - areas.begin();
+	triangle = std::min(triangle, areas.size() - 1);
+
+	float s = std::sqrt(r1);
+	fillHit((uint32_t)triangle, s * (1.0f - r2), s * r2, sample);
+	sample.distance = 0.0f;
+	return true;
+}
+
+size_t MeshBVH::getNodeCount() const
+{
+	return nodes.size();
+}
+
+uint32_t MeshBVH::getDepth() const
+{
+	return depth;
+}
+
+size_t MeshBVH::getTriangleCount() const
+{
+	return triangleIds.size();
+}
+
+float MeshBVH::getSurfaceArea() const
+{
+	return areas.size() ? (float)areas.back() : 0.0f;
+}
+
+double MeshBVH::getBuildTime() const
+{
+	return buildTime;
+}
+
+void MeshBVH::benchmark()
+{
+	using Clock = std::chrono::high_resolution_clock;
+	const int gridSizes[] = { 128, 256, 512, 708 };
+	const int queries = 100000;
+
+	std::mt19937 engine(1234);
+	std::uniform_real_distribution<float> unitDist(0.0f, 1.0f);
+
+	for (int size : gridSizes)
+	{
+		// rolling terrain, the usual shape of a stage's ground
+		std::vector<VertexData> vertices((size + 1) * (size + 1));
+		for (int z = 0; z <= size; ++z)
+		{
+			for (int x = 0; x <= size; ++x)
+			{
+				float fx = (float)x / size * 200.0f - 100.0f;
+				float fz = (float)z / size * 200.0f - 100.0f;
+				vertices[z * (size + 1) + x].position = Glitter::Vector3(fx, std::sin(fx * 0.1f) * std::cos(fz * 0.13f) * 5.0f, fz);
+			}
+		}
+
+		std::vector<unsigned int> indices;
+		indices.reserve(size * size * 6);
+		for (int z = 0; z < size; ++z)
+		{
+			for (int x = 0; x < size; ++x)
+			{
+				unsigned int i = z * (size + 1) + x;
+				unsigned int quad[6] = { i, i + size + 1, i + 1, i + 1, i + size + 1, i + size + 2 };
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+		}
+
+		MeshBVH bvh;
+		bvh.build(vertices, indices);
+
+		BVHHit hit;
+		size_t rayHits = 0, pointHits = 0;
+
+		auto t0 = Clock::now();
+		for (int i = 0; i < queries; ++i)
+		{
+			XMVECTOR origin = XMVectorSet(unitDist(engine) * 200.0f - 100.0f, 20.0f, unitDist(engine) * 200.0f - 100.0f, 0.0f);
+			XMVECTOR direction = XMVectorSet(unitDist(engine) - 0.5f, -1.0f, unitDist(engine) - 0.5f, 0.0f);
+			rayHits += bvh.rayCast(origin, direction, 1000.0f, hit);
+		}
+
+		auto t1 = Clock::now();
+		for (int i = 0; i < queries; ++i)
+		{
+			XMVECTOR point = XMVectorSet(unitDist(engine) * 200.0f - 100.0f, unitDist(engine) * 20.0f - 10.0f, unitDist(engine) * 200.0f - 100.0f, 0.0f);
+			pointHits += bvh.closestPoint(point, 1000.0f, hit);
+		}
+
+		auto t2 = Clock::now();
+		for (int i = 0; i < queries; ++i)
+			bvh.sampleSurface(unitDist(engine), unitDist(engine), unitDist(engine), hit);
+
+		auto t3 = Clock::now();
+		double rayTime = std::chrono::duration<double>(t1 - t0).count();
+		double pointTime = std::chrono::duration<double>(t2 - t1).count();
+		double sampleTime = std::chrono::duration<double>(t3 - t2).count();
+
+		char msg[256];
+		snprintf(msg, sizeof(msg), "mesh bvh %zu triangles (%zu nodes, depth %u): build %.1fms, %.2fM rays/s (%zu hits), %.2fM closest points/s (%zu), %.2fM samples/s",
+			bvh.getTriangleCount(), bvh.getNodeCount(), bvh.getDepth(), bvh.getBuildTime(), queries / rayTime / 1e6, rayHits,
+			queries / pointTime / 1e6, pointHits, queries / sampleTime / 1e6);
+		Logger::log(Message(MessageType::Normal, msg));
+	}
+}
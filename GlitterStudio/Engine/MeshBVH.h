@@ -0,0 +1,66 @@
+#pragma once
+#include "..\Dependencies\DirectXMath-master\Inc\DirectXMath.h"
+#include <cstdint>
+#include <vector>
+
+struct VertexData;
+
+// children of an inner node are stored next to each other
+struct BVHNode
+{
+	DirectX::XMFLOAT3 min;
+	uint32_t first;
+	DirectX::XMFLOAT3 max;
+	uint32_t count;
+};
+
+struct BVHHit
+{
+	float distance = 0.0f;
+
+	// triangle index as given to build, and barycentrics of its second and third vertex
+	uint32_t triangle = 0;
+	float u = 0.0f;
+	float v = 0.0f;
+
+	DirectX::XMFLOAT3 position{ 0.0f, 0.0f, 0.0f };
+	DirectX::XMFLOAT3 normal{ 0.0f, 1.0f, 0.0f };
+};
+
+/// <summary>
+/// Bounding volume hierarchy over a model's triangles, built with a binned surface area heuristic.
+/// Supports ray casts, closest point queries and area weighted surface samples.
+/// </summary>
+class MeshBVH
+{
+private:
+	std::vector<BVHNode> nodes;
+	std::vector<DirectX::XMFLOAT3> positions;
+	std::vector<uint32_t> triangleIds;
+
+	// running totals of triangle area in leaf order, in double so small triangles late in a large mesh keep their share
+	std::vector<double> areas;
+	uint32_t depth;
+	double buildTime;
+
+	void fillHit(uint32_t triangle, float u, float v, BVHHit& hit) const;
+
+public:
+	MeshBVH();
+
+	void build(const std::vector<VertexData>& vertices, const std::vector<unsigned int>& indices);
+	void clear();
+	bool empty() const;
+
+	bool rayCast(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float maxDistance, BVHHit& hit) const;
+	bool closestPoint(DirectX::FXMVECTOR point, float maxDistance, BVHHit& hit) const;
+	bool sampleSurface(float r0, float r1, float r2, BVHHit& sample) const;
+
+	size_t getNodeCount() const;
+	uint32_t getDepth() const;
+	size_t getTriangleCount() const;
+	float getSurfaceArea() const;
+	double getBuildTime() const;
+
+	static void benchmark();
+};
@@ -25,4 +25,10 @@ void MeshData::draw(Shader* shader, float time)
 {
 	for (auto& submesh : submeshes)
 		submesh.draw(shader, time);
+}
+
+void MeshData::drawInstanced(Shader* shader, float time, unsigned int buffer, size_t count)
+{
+	for (auto& submesh : submeshes)
+		submesh.drawInstanced(shader, time, buffer, count);
 }
\ No newline at end of file
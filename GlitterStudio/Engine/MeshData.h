@@ -13,6 +13,7 @@ public:
 	void dispose();
 	void addSubmesh(SubmeshData &submesh);
 	void draw(Shader* shader, float time);
+	void drawInstanced(Shader* shader, float time, unsigned int buffer, size_t count);
 	
 	inline std::vector<SubmeshData>& getSubmeshes() { return submeshes; }
 };
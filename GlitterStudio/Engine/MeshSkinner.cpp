@@ -0,0 +1,201 @@
+#include "MeshSkinner.h"
+#include "../Logger.h"
+#include <chrono>
+#include <cmath>
+#include <random>
+
+using namespace DirectX;
+
+MeshSkinner::MeshSkinner() : skinTime{ 0.0 }
+{
+}
+
+bool MeshSkinner::skin(const std::vector<SkinVertex>& vertices, const std::vector<XMFLOAT4X4>& bonePalette, size_t boneCount)
+{
+	// every bone a vertex can reference needs a matrix
+	if (bonePalette.size() < boneCount || (boneCount == 0 && vertices.size()))
+		return false;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	palette.resize(bonePalette.size());
+	for (size_t i = 0; i < bonePalette.size(); ++i)
+		palette[i] = XMLoadFloat4x4(&bonePalette[i]);
+
+	positions.resize(vertices.size());
+	normals.resize(vertices.size());
+	skinVertices(vertices.data(), vertices.size(), palette.data(), positions.data(), normals.data());
+
+	skinTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return true;
+}
+
+void MeshSkinner::clear()
+{
+	positions.clear();
+	normals.clear();
+	skinTime = 0.0;
+}
+
+bool MeshSkinner::empty() const
+{
+	return positions.empty();
+}
+
+const std::vector<XMFLOAT3>& MeshSkinner::getPositions() const
+{
+	return positions;
+}
+
+const std::vector<XMFLOAT3>& MeshSkinner::getNormals() const
+{
+	return normals;
+}
+
+double MeshSkinner::getSkinTime() const
+{
+	return skinTime;
+}
+
+void MeshSkinner::skinVertices(const SkinVertex* vertices, size_t count, const XMMATRIX* palette, XMFLOAT3* positions, XMFLOAT3* normals)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const SkinVertex& vertex = vertices[i];
+		XMVECTOR position = XMVectorSet(vertex.position.x, vertex.position.y, vertex.position.z, 1.0f);
+		XMVECTOR normal = XMVectorSet(vertex.normal.x, vertex.normal.y, vertex.normal.z, 0.0f);
+
+		XMMATRIX blend;
+		if (vertex.boneWeights[0] == 0xFF)
+		{
+			// rigidly bound, the common case for most of a character
+			blend = palette[vertex.boneIndices[0]];
+		}
+		else
+		{
+			const uint8_t* w = vertex.boneWeights;
+			int total = w[0] + w[1] + w[2] + w[3];
+			if (!total)
+			{
+				XMStoreFloat3(&positions[i], position);
+				XMStoreFloat3(&normals[i], normal);
+				continue;
+			}
+
+			// influences dropped by the bone table don't count towards the total
+			XMVECTOR weights = XMVectorScale(XMVectorSet(w[0], w[1], w[2], w[3]), 1.0f / total);
+			XMVECTOR w0 = XMVectorSplatX(weights);
+			XMVECTOR w1 = XMVectorSplatY(weights);
+			XMVECTOR w2 = XMVectorSplatZ(weights);
+			XMVECTOR w3 = XMVectorSplatW(weights);
+
+			// zero weighted influences still point at a valid bone, so all four are blended without branching
+			const XMMATRIX& m0 = palette[vertex.boneIndices[0]];
+			const XMMATRIX& m1 = palette[vertex.boneIndices[1]];
+			const XMMATRIX& m2 = palette[vertex.boneIndices[2]];
+			const XMMATRIX& m3 = palette[vertex.boneIndices[3]];
+			for (int row = 0; row < 4; ++row)
+			{
+				XMVECTOR r = XMVectorMultiply(m0.r[row], w0);
+				r = XMVectorMultiplyAdd(m1.r[row], w1, r);
+				r = XMVectorMultiplyAdd(m2.r[row], w2, r);
+				blend.r[row] = XMVectorMultiplyAdd(m3.r[row], w3, r);
+			}
+		}
+
+		XMStoreFloat3(&positions[i], XMVector3Transform(position, blend));
+		XMStoreFloat3(&normals[i], XMVector3Normalize(XMVector3TransformNormal(normal, blend)));
+	}
+}
+
+// plain float version of skinVertices, only used as a baseline for the benchmark
+static void skinVerticesScalar(const SkinVertex* vertices, size_t count, const XMFLOAT4X4* palette, XMFLOAT3* positions, XMFLOAT3* normals)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const SkinVertex& vertex = vertices[i];
+		float blend[4][4] = {};
+		for (int influence = 0; influence < 4; ++influence)
+		{
+			float w = vertex.boneWeights[influence] / 255.0f;
+			const XMFLOAT4X4& m = palette[vertex.boneIndices[influence]];
+			for (int r = 0; r < 4; ++r)
+				for (int c = 0; c < 4; ++c)
+					blend[r][c] += m.m[r][c] * w;
+		}
+
+		const XMFLOAT3& p = vertex.position;
+		const XMFLOAT3& n = vertex.normal;
+		float nx = n.x * blend[0][0] + n.y * blend[1][0] + n.z * blend[2][0];
+		float ny = n.x * blend[0][1] + n.y * blend[1][1] + n.z * blend[2][1];
+		float nz = n.x * blend[0][2] + n.y * blend[1][2] + n.z * blend[2][2];
+		float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+		float inv = length > 0.0f ? 1.0f / length : 0.0f;
+
+		positions[i] = XMFLOAT3(p.x * blend[0][0] + p.y * blend[1][0] + p.z * blend[2][0] + blend[3][0],
+			p.x * blend[0][1] + p.y * blend[1][1] + p.z * blend[2][1] + blend[3][1],
+			p.x * blend[0][2] + p.y * blend[1][2] + p.z * blend[2][2] + blend[3][2]);
+		normals[i] = XMFLOAT3(nx * inv, ny * inv, nz * inv);
+	}
+}
+
+void MeshSkinner::benchmark()
+{
+	using Clock = std::chrono::high_resolution_clock;
+	const size_t vertexCount = 100000;
+	const size_t boneCount = 64;
+	const int iterations = 20;
+
+	std::mt19937 engine(1234);
+	std::uniform_real_distribution<float> unitDist(-1.0f, 1.0f);
+	std::uniform_int_distribution<int> boneDist(0, boneCount - 1);
+
+	std::vector<XMFLOAT4X4> bonePalette(boneCount);
+	for (XMFLOAT4X4& m : bonePalette)
+	{
+		XMMATRIX rotation = XMMatrixRotationRollPitchYaw(unitDist(engine), unitDist(engine), unitDist(engine));
+		XMStoreFloat4x4(&m, XMMatrixMultiply(rotation, XMMatrixTranslation(unitDist(engine), unitDist(engine), unitDist(engine))));
+	}
+
+	// rigid: every vertex on one bone. blended: up to four influences, like joints and faces
+	const char* names[] = { "rigid", "blended" };
+	for (int mode = 0; mode < 2; ++mode)
+	{
+		std::vector<SkinVertex> vertices(vertexCount);
+		for (SkinVertex& v : vertices)
+		{
+			v.position = XMFLOAT3(unitDist(engine), unitDist(engine), unitDist(engine));
+			v.normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+
+			int remaining = 255;
+			for (int influence = 0; influence < 4; ++influence)
+			{
+				int weight = mode == 0 ? (influence == 0 ? 255 : 0) : (influence == 3 ? remaining : std::uniform_int_distribution<int>(0, remaining)(engine));
+				v.boneIndices[influence] = boneDist(engine);
+				v.boneWeights[influence] = weight;
+				remaining -= weight;
+			}
+		}
+
+		MeshSkinner skinner;
+		std::vector<XMFLOAT3> positions(vertexCount), normals(vertexCount);
+		double simdTime = 0.0, scalarTime = 0.0;
+		for (int i = 0; i < iterations; ++i)
+		{
+			auto t0 = Clock::now();
+			skinner.skin(vertices, bonePalette, boneCount);
+
+			auto t1 = Clock::now();
+			skinVerticesScalar(vertices.data(), vertexCount, bonePalette.data(), positions.data(), normals.data());
+
+			auto t2 = Clock::now();
+			simdTime += std::chrono::duration<double>(t1 - t0).count();
+			scalarTime += std::chrono::duration<double>(t2 - t1).count();
+		}
+
+		char msg[256];
+		snprintf(msg, sizeof(msg), "skinning %zu %s vertices on one core: SIMD %.1fM vertices/s, scalar %.1fM vertices/s",
+			vertexCount, names[mode], vertexCount * iterations / simdTime / 1e6, vertexCount * iterations / scalarTime / 1e6);
+		Logger::log(Message(MessageType::Normal, msg));
+	}
+}
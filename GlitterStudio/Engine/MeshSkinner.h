@@ -0,0 +1,40 @@
+#pragma once
+#include "..\Dependencies\DirectXMath-master\Inc\DirectXMath.h"
+#include <vector>
+#include <cstdint>
+
+// the vertex attributes skinning reads. bone indices address the palette and weights add up to 255
+struct SkinVertex
+{
+	DirectX::XMFLOAT3 position;
+	DirectX::XMFLOAT3 normal;
+	uint8_t boneIndices[4];
+	uint8_t boneWeights[4];
+};
+
+/// <summary>
+/// Skins vertices on the CPU into reusable position and normal buffers.
+/// Palettes hold one matrix per skeleton bone (bone world transform times inverse bind pose) in DirectXMath's row vector convention.
+/// </summary>
+class MeshSkinner
+{
+private:
+	std::vector<DirectX::XMFLOAT3> positions;
+	std::vector<DirectX::XMFLOAT3> normals;
+	std::vector<DirectX::XMMATRIX> palette;
+	double skinTime;
+
+public:
+	MeshSkinner();
+
+	bool skin(const std::vector<SkinVertex>& vertices, const std::vector<DirectX::XMFLOAT4X4>& bonePalette, size_t boneCount);
+	void clear();
+	bool empty() const;
+
+	const std::vector<DirectX::XMFLOAT3>& getPositions() const;
+	const std::vector<DirectX::XMFLOAT3>& getNormals() const;
+	double getSkinTime() const;
+
+	static void skinVertices(const SkinVertex* vertices, size_t count, const DirectX::XMMATRIX* palette, DirectX::XMFLOAT3* positions, DirectX::XMFLOAT3* normals);
+	static void benchmark();
+};
@@ -0,0 +1,272 @@
+#include "ModelCache.h"
+#include "File.h"
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <random>
+#include <cstring>
+#include <cstddef>
+
+static_assert(sizeof(ModelCacheHeader) == 96, "ModelCacheHeader is part of the .glcache layout");
+static_assert(sizeof(ModelCacheSubmesh) == 32, "ModelCacheSubmesh is part of the .glcache layout");
+
+std::string ModelCache::directory;
+
+// tables start on 16 byte boundaries
+static uint64_t alignTable(uint64_t offset)
+{
+	return (offset + 15) & ~(uint64_t)15;
+}
+
+std::string ModelCacheView::getName(const ModelCacheSubmesh& submesh) const
+{
+	return std::string(names + submesh.nameOffset, submesh.nameSize);
+}
+
+void ModelCacheBuffers::addSubmesh(uint32_t mesh, const std::string& materialName, size_t vertexCount, size_t indexCount)
+{
+	// the submesh's vertices and indices are the last ones appended
+	ModelCacheSubmesh submesh{};
+	submesh.mesh = mesh;
+	submesh.vertexStart = vertices.size() - vertexCount;
+	submesh.vertexCount = vertexCount;
+	submesh.indexStart = indices.size() - indexCount;
+	submesh.indexCount = indexCount;
+	submesh.nameOffset = names.size();
+	submesh.nameSize = materialName.size();
+
+	names += materialName;
+	submeshes.push_back(submesh);
+}
+
+ModelCacheView ModelCacheBuffers::getView() const
+{
+	ModelCacheView view;
+	view.meshCount = meshCount;
+	view.radius = radius;
+	view.submeshes = submeshes.data();
+	view.submeshCount = submeshes.size();
+	view.vertices = vertices.data();
+	view.vertexCount = vertices.size();
+	view.indices = indices.data();
+	view.indexCount = indices.size();
+	view.names = names.data();
+	view.nameSize = names.size();
+
+	return view;
+}
+
+void ModelCache::setDirectory(const std::string& dir)
+{
+	directory = dir;
+}
+
+bool ModelCache::isEnabled()
+{
+	return directory.size();
+}
+
+uint64_t ModelCache::hashBytes(const void* data, size_t size, uint64_t hash)
+{
+	// FNV-1a
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3;
+	}
+
+	return hash;
+}
+
+uint64_t ModelCache::hashFile(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+	std::vector<char> buffer(1 << 16);
+	uint64_t hash = hashBytes(nullptr, 0);
+
+	while (file)
+	{
+		file.read(buffer.data(), buffer.size());
+		hash = hashBytes(buffer.data(), (size_t)file.gcount(), hash);
+	}
+
+	return hash;
+}
+
+std::string ModelCache::getCachePath(const std::string& source)
+{
+	std::error_code error;
+	std::string absolute = std::filesystem::absolute(source, error).string();
+	std::transform(absolute.begin(), absolute.end(), absolute.begin(), ::tolower);
+
+	char key[17];
+	snprintf(key, sizeof(key), "%016llx", (unsigned long long)hashBytes(absolute.data(), absolute.size()));
+
+	return directory + Glitter::File::getFileNameWithoutExtension(source) + "-" + key + ".glcache";
+}
+
+bool ModelCache::getSourceInfo(const std::string& source, uint64_t& size, int64_t& time)
+{
+	std::error_code error;
+	size = std::filesystem::file_size(source, error);
+	if (error)
+		return false;
+
+	time = std::filesystem::last_write_time(source, error).time_since_epoch().count();
+	return !error;
+}
+
+bool ModelCache::updateSourceTime(const std::string& cachePath, int64_t time)
+{
+	std::fstream file(cachePath, std::ios::binary | std::ios::in | std::ios::out);
+	if (!file)
+		return false;
+
+	file.seekp(offsetof(ModelCacheHeader, sourceTime));
+	file.write((const char*)&time, sizeof(time));
+	return (bool)file;
+}
+
+std::unique_ptr<Glitter::MappedFile> ModelCache::open(const std::string& source, ModelCacheView& view)
+{
+	uint64_t sourceSize;
+	int64_t sourceTime;
+	if (!isEnabled() || !getSourceInfo(source, sourceSize, sourceTime))
+		return nullptr;
+
+	std::string cachePath = getCachePath(source);
+	if (!Glitter::File::exists(cachePath))
+		return nullptr;
+
+	auto file = std::make_unique<Glitter::MappedFile>(cachePath);
+	size_t fileSize = file->getSize();
+	if (!file->valid() || fileSize < sizeof(ModelCacheHeader))
+		return nullptr;
+
+	const unsigned char* data = file->getData();
+	const ModelCacheHeader* header = (const ModelCacheHeader*)data;
+	if (std::memcmp(header->magic, "GLCH", 4) != 0 || header->version != modelCacheVersion || header->vertexSize != sizeof(VertexData))
+		return nullptr;
+
+	if (header->sourceSize != sourceSize)
+		return nullptr;
+
+	// a touched or copied source costs one hash of its contents, then the header takes its new time.
+	// the mapping doesn't share write access, so it is released for the update and taken again.
+	if (header->sourceTime != sourceTime)
+	{
+		if (header->sourceHash != hashFile(source))
+			return nullptr;
+
+		file.reset();
+		updateSourceTime(cachePath, sourceTime);
+
+		file = std::make_unique<Glitter::MappedFile>(cachePath);
+		if (!file->valid() || file->getSize() != fileSize)
+			return nullptr;
+
+		data = file->getData();
+		header = (const ModelCacheHeader*)data;
+	}
+
+	auto fits = [fileSize](uint64_t offset, uint64_t count, size_t stride) { return offset <= fileSize && count <= (fileSize - offset) / stride; };
+	if (!fits(header->submeshOffset, header->submeshCount, sizeof(ModelCacheSubmesh)) ||
+		!fits(header->vertexOffset, header->vertexCount, sizeof(VertexData)) ||
+		!fits(header->indexOffset, header->indexCount, sizeof(unsigned int)) ||
+		!fits(header->nameOffset, header->nameSize, 1))
+		return nullptr;
+
+	view.meshCount = header->meshCount;
+	view.radius = header->radius;
+	view.submeshes = (const ModelCacheSubmesh*)(data + header->submeshOffset);
+	view.submeshCount = header->submeshCount;
+	view.vertices = (const VertexData*)(data + header->vertexOffset);
+	view.vertexCount = header->vertexCount;
+	view.indices = (const unsigned int*)(data + header->indexOffset);
+	view.indexCount = header->indexCount;
+	view.names = (const char*)(data + header->nameOffset);
+	view.nameSize = header->nameSize;
+
+	for (size_t i = 0; i < view.submeshCount; ++i)
+	{
+		const ModelCacheSubmesh& submesh = view.submeshes[i];
+		if (submesh.mesh >= view.meshCount ||
+			(uint64_t)submesh.vertexStart + submesh.vertexCount > view.vertexCount ||
+			(uint64_t)submesh.indexStart + submesh.indexCount > view.indexCount ||
+			(uint64_t)submesh.nameOffset + submesh.nameSize > view.nameSize)
+			return nullptr;
+	}
+
+	return file;
+}
+
+bool ModelCache::save(const std::string& source, const ModelCacheBuffers& buffers)
+{
+	uint64_t sourceSize;
+	int64_t sourceTime;
+	if (!isEnabled() || !getSourceInfo(source, sourceSize, sourceTime))
+		return false;
+
+	ModelCacheHeader header{};
+	std::memcpy(header.magic, "GLCH", 4);
+	header.version = modelCacheVersion;
+	header.vertexSize = sizeof(VertexData);
+	header.meshCount = buffers.meshCount;
+	header.sourceHash = hashFile(source);
+	header.sourceSize = sourceSize;
+	header.sourceTime = sourceTime;
+	header.radius = buffers.radius;
+
+	header.submeshCount = buffers.submeshes.size();
+	header.vertexCount = buffers.vertices.size();
+	header.indexCount = buffers.indices.size();
+	header.nameSize = buffers.names.size();
+
+	header.submeshOffset = alignTable(sizeof(ModelCacheHeader));
+	header.vertexOffset = alignTable(header.submeshOffset + header.submeshCount * sizeof(ModelCacheSubmesh));
+	header.indexOffset = alignTable(header.vertexOffset + (uint64_t)header.vertexCount * sizeof(VertexData));
+	header.nameOffset = alignTable(header.indexOffset + (uint64_t)header.indexCount * sizeof(unsigned int));
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+
+	// written under a temporary name first, so other processes never map a partial file
+	std::string cachePath = getCachePath(source);
+	std::string tempPath = cachePath + "." + std::to_string(std::random_device()()) + ".tmp";
+
+	{
+		std::ofstream file(tempPath, std::ios::binary);
+		if (!file)
+			return false;
+
+		auto writeTable = [&file](uint64_t offset, const void* data, size_t size)
+		{
+			static const char padding[16] = {};
+			file.write(padding, offset - (uint64_t)file.tellp());
+			file.write((const char*)data, size);
+		};
+
+		file.write((const char*)&header, sizeof(ModelCacheHeader));
+		writeTable(header.submeshOffset, buffers.submeshes.data(), buffers.submeshes.size() * sizeof(ModelCacheSubmesh));
+		writeTable(header.vertexOffset, buffers.vertices.data(), buffers.vertices.size() * sizeof(VertexData));
+		writeTable(header.indexOffset, buffers.indices.data(), buffers.indices.size() * sizeof(unsigned int));
+		writeTable(header.nameOffset, buffers.names.data(), buffers.names.size());
+
+		if (!file)
+		{
+			file.close();
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(tempPath, cachePath, error);
+	if (error)
+	{
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+
+	return true;
+}
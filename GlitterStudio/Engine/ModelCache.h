@@ -0,0 +1,98 @@
+#pragma once
+#include "SubmeshData.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+constexpr uint32_t modelCacheVersion = 3;
+
+struct ModelCacheHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t vertexSize;
+	uint32_t meshCount;
+	uint64_t sourceHash;
+	uint64_t sourceSize;
+	int64_t sourceTime;
+	uint64_t submeshOffset;
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+	uint64_t nameOffset;
+	uint32_t submeshCount;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint32_t nameSize;
+	float radius;
+	uint32_t reserved;
+};
+
+// indices are relative to the submesh's own first vertex
+struct ModelCacheSubmesh
+{
+	uint32_t mesh;
+	uint32_t vertexStart;
+	uint32_t vertexCount;
+	uint32_t indexStart;
+	uint32_t indexCount;
+	uint32_t nameOffset;
+	uint32_t nameSize;
+	uint32_t reserved;
+};
+
+// tables of a mapped cache file, or of buffers built from the source model
+struct ModelCacheView
+{
+	uint32_t meshCount = 0;
+	float radius = 0.0f;
+	const ModelCacheSubmesh* submeshes = nullptr;
+	size_t submeshCount = 0;
+	const VertexData* vertices = nullptr;
+	size_t vertexCount = 0;
+	const unsigned int* indices = nullptr;
+	size_t indexCount = 0;
+	const char* names = nullptr;
+	size_t nameSize = 0;
+
+	std::string getName(const ModelCacheSubmesh& submesh) const;
+};
+
+struct ModelCacheBuffers
+{
+	uint32_t meshCount = 0;
+	float radius = 0.0f;
+	std::vector<ModelCacheSubmesh> submeshes;
+	std::vector<VertexData> vertices;
+	std::vector<unsigned int> indices;
+	std::string names;
+
+	void addSubmesh(uint32_t mesh, const std::string& materialName, size_t vertexCount, size_t indexCount);
+	ModelCacheView getView() const;
+};
+
+/// <summary>
+/// Derived .glcache files holding a model's vertex and index buffers already laid out for upload,
+/// along with its submesh and material tables. Caches are keyed by the source path, validated against the
+/// source's size, time and content hash, and memory mapped when loaded.
+/// Files are written in the layout of the running build, so VertexData changes need a version bump.
+/// </summary>
+class ModelCache
+{
+private:
+	static std::string directory;
+
+	static std::string getCachePath(const std::string& source);
+	static bool getSourceInfo(const std::string& source, uint64_t& size, int64_t& time);
+	static bool updateSourceTime(const std::string& cachePath, int64_t time);
+	static uint64_t hashFile(const std::string& filename);
+	static uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325);
+
+public:
+	static void setDirectory(const std::string& dir);
+	static bool isEnabled();
+
+	static std::unique_ptr<Glitter::MappedFile> open(const std::string& source, ModelCacheView& view);
+	static bool save(const std::string& source, const ModelCacheBuffers& buffers);
+};
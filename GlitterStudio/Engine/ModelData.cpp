@@ -4,13 +4,15 @@
 #include "ResourceManager.h"
 #include "../Logger.h"
 #include <filesystem>
+#include <algorithm>
+#include <cstring>
 
-ModelData::ModelData(const std::string& path)
+ModelData::ModelData(const std::string& path) : radius{ 0.0f }
 {
 	reload(path);
 }
 
-ModelData::ModelData()
+ModelData::ModelData() : radius{ 0.0f }
 {
 
 }
@@ -21,70 +23,63 @@ void ModelData::dispose()
 		mesh.dispose();
 }
 
-void ModelData::buildGensModel(Glitter::Model &model)
+void ModelData::buildGensModel(Glitter::Model &model, ModelCacheBuffers& buffers)
 {
-	if (!std::filesystem::exists(directory))
-		return;
-
 	std::vector<Glitter::Mesh*> gensMeshes = model.getMeshes();
-	meshes.reserve(meshes.size());
+	buffers.meshCount = gensMeshes.size();
+	buffers.vertices.reserve(model.getVertexCount());
 
 	for (int i = 0; i < gensMeshes.size(); ++i)
 	{
-		MeshData meshData;
 		for (int slot = 0; slot < Glitter::MODEL_SUBMESH_SLOTS; ++slot)
 		{
 			std::vector<Glitter::Submesh*> slotSubmeshes = gensMeshes[i]->getSubmeshes(slot);
 
 			for (int sub = 0; sub < slotSubmeshes.size(); ++sub)
-			{
-				SubmeshData submeshData = buildGensSubMesh(slotSubmeshes[sub]);
-				submeshData.appendVerticesTo(vertices);
-				meshData.addSubmesh(submeshData);
-			}
+				buildGensSubMesh(slotSubmeshes[sub], i, buffers);
 		}
-
-		meshes.push_back(meshData);
 	}
+
+	// bounding sphere around the model origin, used for culling mesh particles
+	for (auto& v : buffers.vertices)
+		buffers.radius = std::max(buffers.radius, v.position.length());
 }
 
-SubmeshData ModelData::buildGensSubMesh(Glitter::Submesh *submesh)
+void ModelData::buildGensSubMesh(Glitter::Submesh *submesh, uint32_t mesh, ModelCacheBuffers& buffers)
 {
 	// process vertices
-	std::list<Glitter::Vertex*> vertices = submesh->getVerticesList();
-	std::vector<VertexData> vertexData;
-	vertexData.reserve(vertices.size());
+	const std::vector<Glitter::Vertex>& vertices = submesh->getVertices();
 
-	for (std::list<Glitter::Vertex*>::iterator vIt = vertices.begin(); vIt != vertices.end(); ++vIt)
+	for (const Glitter::Vertex& vertex : vertices)
 	{
-		Glitter::Vertex* vertex = (*vIt);
 		VertexData vData;
 
-		vData.position	= vertex->getPosition();
-		vData.normal	= vertex->getNormal();
-		vData.tangent	= vertex->getTangent();
-		vData.binormal	= vertex->getBinormal();
+		vData.position	= vertex.getPosition();
+		vData.normal	= vertex.getNormal();
+		vData.tangent	= vertex.getTangent();
+		vData.binormal	= vertex.getBinormal();
 
 		for (int channel = 0; channel < 4; ++channel)
-			vData.uv[channel] = vertex->getUV(channel);
+			vData.uv[channel] = vertex.getUV(channel);
 
-		vData.color = vertex->getColor();
+		vData.color = vertex.getColor();
 
-		vertexData.emplace_back(vData);
+		buffers.vertices.emplace_back(vData);
 	}
 
-	// process faces
-	std::list<unsigned int> faces = submesh->getFacesList();
-	std::vector<unsigned int> faceData;
-	faceData.reserve(faces.size());
+	// process faces. triangles are already laid out as an index buffer
+	const std::vector<Glitter::Polygon>& triangles = submesh->getTriangles();
+	size_t indexStart = buffers.indices.size();
+	buffers.indices.resize(indexStart + triangles.size() * 3);
+	if (triangles.size())
+		std::memcpy(&buffers.indices[indexStart], triangles.data(), triangles.size() * sizeof(Glitter::Polygon));
 
-	for (std::list<unsigned int>::iterator fIt = faces.begin(); fIt != faces.end(); ++fIt)
-	{
-		faceData.emplace_back((*fIt));
-	}
+	buffers.addSubmesh(mesh, submesh->getMaterialName(), vertices.size(), triangles.size() * 3);
+}
 
+MaterialData ModelData::buildMaterial(const std::string& materialName)
+{
 	// process materials
-	std::string materialName = submesh->getMaterialName();
 	ResourceManager::loadMaterial(directory + materialName + ".material");
 
 	MaterialData matData;
@@ -121,7 +116,26 @@ SubmeshData ModelData::buildGensSubMesh(Glitter::Submesh *submesh)
 			matData.textures.emplace_back(texture);
 	}
 
-	return SubmeshData(vertexData, faceData, matData, PirimitveType::TriangleStrip);
+	return matData;
+}
+
+void ModelData::build(const ModelCacheView& view)
+{
+	if (!std::filesystem::exists(directory))
+		return;
+
+	vertices.assign(view.vertices, view.vertices + view.vertexCount);
+	radius = view.radius;
+	meshes.resize(view.meshCount);
+
+	for (size_t i = 0; i < view.submeshCount; ++i)
+	{
+		const ModelCacheSubmesh& submesh = view.submeshes[i];
+		SubmeshData submeshData(view.vertices + submesh.vertexStart, submesh.vertexCount, view.indices + submesh.indexStart, submesh.indexCount,
+			buildMaterial(view.getName(submesh)), PirimitveType::Triangle);
+
+		meshes[submesh.mesh].addSubmesh(submeshData);
+	}
 }
 
 void ModelData::draw(Shader* shader, float time)
@@ -130,11 +144,22 @@ void ModelData::draw(Shader* shader, float time)
 		mesh.draw(shader, time);
 }
 
+void ModelData::drawInstanced(Shader* shader, float time, unsigned int buffer, size_t count)
+{
+	for (auto& mesh : meshes)
+		mesh.drawInstanced(shader, time, buffer, count);
+}
+
 std::vector<VertexData>& ModelData::getVertices()
 {
 	return vertices;
 }
 
+float ModelData::getRadius() const
+{
+	return radius;
+}
+
 bool ModelData::reload(const std::string& path)
 {
 	if (!Glitter::File::exists(path))
@@ -143,10 +168,24 @@ bool ModelData::reload(const std::string& path)
 		return false;
 	}
 
-	Glitter::Model model(path);
 	modelName = Glitter::File::getFileName(path);
 	directory = Glitter::File::getFilePath(path);
-	buildGensModel(model);
+
+	// a valid cache skips parsing; its buffers are uploaded straight from the mapped file
+	ModelCacheView view;
+	std::unique_ptr<Glitter::MappedFile> cache = ModelCache::open(path, view);
+	if (cache)
+	{
+		build(view);
+		return true;
+	}
+
+	// strips are only needed to save the model again
+	Glitter::Model model(path, false);
+	ModelCacheBuffers buffers;
+	buildGensModel(model, buffers);
+	ModelCache::save(path, buffers);
+	build(buffers.getView());
 
 	return true;
 }
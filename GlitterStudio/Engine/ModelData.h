@@ -1,5 +1,6 @@
 #pragma once
 #include "MeshData.h"
+#include "ModelCache.h"
 #include "Model.h"
 #include "Shader.h"
 
@@ -11,8 +12,11 @@ private:
 	std::vector<VertexData> vertices;
 	std::string modelName;
 	std::string directory;
+	float radius;
 
-	SubmeshData buildGensSubMesh(Glitter::Submesh *submesh);
+	void buildGensSubMesh(Glitter::Submesh *submesh, uint32_t mesh, ModelCacheBuffers& buffers);
+	MaterialData buildMaterial(const std::string& materialName);
+	void build(const ModelCacheView& view);
 
 public:
 	ModelData(const std::string& path);
@@ -20,10 +24,12 @@ public:
 
 	bool reload(const std::string& path);
 	void dispose();
-	void buildGensModel(Glitter::Model &model);
+	void buildGensModel(Glitter::Model &model, ModelCacheBuffers& buffers);
 	void draw(Shader* shader, float time);
+	void drawInstanced(Shader* shader, float time, unsigned int buffer, size_t count);
 
 	std::vector<VertexData>& getVertices();
+	float getRadius() const;
 	std::vector<std::shared_ptr<Glitter::Material>> getMaterials();
 	std::string getName() const;
 };
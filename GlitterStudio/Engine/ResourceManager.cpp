@@ -1,6 +1,7 @@
 #include "ResourceManager.h"
 #include "../Logger.h"
 #include "File.h"
+#include "TexturePacker.h"
 
 std::vector<std::shared_ptr<ModelData>> ResourceManager::models;
 std::vector<std::shared_ptr<TextureData>> ResourceManager::textures;
@@ -69,7 +70,7 @@ void ResourceManager::loadModel(const std::string& filepath)
 	}
 }
 
-void ResourceManager::loadTexture(const std::string& filepath, TextureSlot slot)
+void ResourceManager::loadTexture(const std::string& filepath, TextureSlot slot, bool packable)
 {
 	const std::string textureName = Glitter::File::getFileName(filepath);
 	std::shared_ptr<TextureData> texture = getTexture(textureName);
@@ -78,6 +79,7 @@ void ResourceManager::loadTexture(const std::string& filepath, TextureSlot slot)
 	if (!texture)
 	{
 		texture = std::make_shared<TextureData>();
+		texture->setPackable(packable);
 		if (texture->reload(filepath, slot))
 		{
 			textures.emplace_back(texture);
@@ -133,6 +135,7 @@ size_t ResourceManager::getTextureCount()
 
 void ResourceManager::disposeAll()
 {
+	TexturePacker::disposeAll();
 	models.clear();
 	textures.clear();
 }
@@ -24,7 +24,7 @@ public:
 	static std::vector<std::shared_ptr<Glitter::Material>> getMaterialList();
 
 	static void loadModel(const std::string& filepath);
-	static void loadTexture(const std::string& filepath, TextureSlot slot);
+	static void loadTexture(const std::string& filepath, TextureSlot slot, bool packable = false);
 	static void loadShader(const std::string& name, const std::string& path);
 	static void loadMaterial(const std::string& filepath);
 	static void disposeAll();
@@ -19,6 +19,11 @@ std::string Shader::getName() const
 	return name;
 }
 
+const MaterialUniforms& Shader::getMaterialUniforms() const
+{
+	return materialUniforms;
+}
+
 void Shader::compile(const std::string &source)
 {
 	std::string vertexCode, fragmentCode;
@@ -93,6 +98,36 @@ void Shader::compile(const std::string &source)
 
 	glDeleteShader(vertex);
 	glDeleteShader(fragment);
+
+	// GLSL 3.30 can't set block bindings in the shader itself
+	GLuint frameBlock = glGetUniformBlockIndex(ID, "FrameData");
+	if (frameBlock != GL_INVALID_INDEX)
+		glUniformBlockBinding(ID, frameBlock, frameDataBinding);
+
+	bindMaterialUniforms();
+}
+
+void Shader::bindMaterialUniforms()
+{
+	static const char* samplerNames[materialTextureSlots] = { "diffuse0", "gloss0", "normal0", "specular0", "emissive0", "displacement0", "reflection0" };
+	static const char* uvIndexNames[materialTextureSlots] = { "diffIndex", "glossIndex", "normIndex", "specIndex", "emsIndex", "disIndex", "refIndex" };
+
+	materialUniforms.diffuse			= getUniform<DirectX::XMFLOAT4>("material.diffuse");
+	materialUniforms.ambient			= getUniform<DirectX::XMFLOAT4>("material.ambient");
+	materialUniforms.specular			= getUniform<DirectX::XMFLOAT4>("material.specular");
+	materialUniforms.emissive			= getUniform<DirectX::XMFLOAT4>("material.emissive");
+	materialUniforms.powerGlossLevel	= getUniform<DirectX::XMFLOAT4>("material.power_gloss_level");
+	materialUniforms.hasNormal			= getUniform<bool>("material.hasNormal");
+	materialUniforms.hasGloss			= getUniform<bool>("material.hasGloss");
+
+	// each material sampler reads from the unit of its slot, so draws only have to bind textures
+	glUseProgram(ID);
+	for (size_t slot = 0; slot < materialTextureSlots; ++slot)
+	{
+		set(getUniform<int>(std::string("material.") + samplerNames[slot]), (int)slot);
+		materialUniforms.uvIndices[slot] = getUniform<int>(std::string("material.") + uvIndexNames[slot]);
+	}
+	glUseProgram(0);
 }
 
 GLint Shader::getUniformLoc(const std::string& name)
@@ -149,3 +184,39 @@ void Shader::setMatrix4(const std::string& name, DirectX::XMMATRIX value)
 {
 	glUniformMatrix4fv(getUniformLoc(name), 1, GL_FALSE, (GLfloat*)&value.r->m128_f32[0]);
 }
+
+
+void Shader::set(Uniform<bool> uniform, bool value)
+{
+	glUniform1i(uniform.getLocation(), (int)value);
+}
+
+void Shader::set(Uniform<int> uniform, int value)
+{
+	glUniform1i(uniform.getLocation(), value);
+}
+
+void Shader::set(Uniform<float> uniform, float value)
+{
+	glUniform1f(uniform.getLocation(), value);
+}
+
+void Shader::set(Uniform<DirectX::XMFLOAT2> uniform, DirectX::XMVECTOR value)
+{
+	glUniform2fv(uniform.getLocation(), 1, (GLfloat*)&value);
+}
+
+void Shader::set(Uniform<DirectX::XMFLOAT3> uniform, DirectX::XMVECTOR value)
+{
+	glUniform3fv(uniform.getLocation(), 1, (GLfloat*)&value);
+}
+
+void Shader::set(Uniform<DirectX::XMFLOAT4> uniform, DirectX::XMVECTOR value)
+{
+	glUniform4fv(uniform.getLocation(), 1, (GLfloat*)&value);
+}
+
+void Shader::set(Uniform<DirectX::XMMATRIX> uniform, DirectX::XMMATRIX value)
+{
+	glUniformMatrix4fv(uniform.getLocation(), 1, GL_FALSE, (GLfloat*)&value.r->m128_f32[0]);
+}
\ No newline at end of file
@@ -1,9 +1,43 @@
 #pragma once
 #include <glad/glad.h>
 #include "..\Dependencies\DirectXMath-master\Inc\DirectXMath.h"
+#include <array>
 #include <string>
 #include <unordered_map>
 
+// uniform block binding point of the per frame FrameData block
+constexpr unsigned int frameDataBinding = 0;
+
+// number of texture slots a mesh material can sample, one texture unit each
+constexpr size_t materialTextureSlots = 7;
+
+// uniform location typed by the value it accepts. resolve once with Shader::getUniform
+template <typename T>
+class Uniform
+{
+private:
+	GLint location;
+
+public:
+	Uniform() : location{ -1 } {}
+	explicit Uniform(GLint loc) : location{ loc } {}
+
+	inline GLint getLocation() const { return location; }
+};
+
+// mesh material uniforms, resolved once the program is linked. slots are in TextureSlot order
+struct MaterialUniforms
+{
+	Uniform<DirectX::XMFLOAT4> diffuse;
+	Uniform<DirectX::XMFLOAT4> ambient;
+	Uniform<DirectX::XMFLOAT4> specular;
+	Uniform<DirectX::XMFLOAT4> emissive;
+	Uniform<DirectX::XMFLOAT4> powerGlossLevel;
+	std::array<Uniform<int>, materialTextureSlots> uvIndices;
+	Uniform<bool> hasNormal;
+	Uniform<bool> hasGloss;
+};
+
 class Shader
 {
 private:
@@ -11,8 +45,10 @@ private:
 	unsigned int uloc;
 	std::string name;
 	std::unordered_map<std::string, GLint> locMap;
+	MaterialUniforms materialUniforms;
 
 	void compile(const std::string& source);
+	void bindMaterialUniforms();
 	GLint getUniformLoc(const std::string& name);
 
 public:	
@@ -20,6 +56,7 @@ public:
 	~Shader();
 
 	std::string getName() const;
+	const MaterialUniforms& getMaterialUniforms() const;
 	void use();
 
 	void setBool(const std::string& name, bool value);
@@ -29,4 +66,15 @@ public:
 	void setVec3(const std::string& name, DirectX::XMVECTOR v);
 	void setVec4(const std::string& name, DirectX::XMVECTOR v);
 	void setMatrix4(const std::string& name, DirectX::XMMATRIX m);
+
+	template <typename T>
+	Uniform<T> getUniform(const std::string& name) { return Uniform<T>(getUniformLoc(name)); }
+
+	void set(Uniform<bool> uniform, bool value);
+	void set(Uniform<int> uniform, int value);
+	void set(Uniform<float> uniform, float value);
+	void set(Uniform<DirectX::XMFLOAT2> uniform, DirectX::XMVECTOR v);
+	void set(Uniform<DirectX::XMFLOAT3> uniform, DirectX::XMVECTOR v);
+	void set(Uniform<DirectX::XMFLOAT4> uniform, DirectX::XMVECTOR v);
+	void set(Uniform<DirectX::XMMATRIX> uniform, DirectX::XMMATRIX m);
 };
\ No newline at end of file
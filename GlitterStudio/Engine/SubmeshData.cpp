@@ -1,14 +1,15 @@
 #include "SubmeshData.h"
 #include "glad/glad.h"
 
-SubmeshData::SubmeshData(const std::vector<VertexData> &v, const std::vector<unsigned int> &i, const MaterialData &m, PirimitveType pirimitive)
+SubmeshData::SubmeshData(const VertexData* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, const MaterialData &m, PirimitveType pirimitive)
 {
-	vertices = v;
-	faces = i;
+	this->indexCount = indexCount;
 	material = m;
 	pirimitiveType = pirimitive;
+	instanceBuffer = 0;
 	
-	build();
+	// buffers are uploaded straight from the caller's memory; only the index count is kept
+	build(vertices, vertexCount, indices);
 }
 
 SubmeshData::~SubmeshData()
@@ -20,7 +21,7 @@ SubmeshData::~SubmeshData()
 	//glDeleteVertexArrays(1, &vao);
 }
 
-void SubmeshData::build()
+void SubmeshData::build(const VertexData* vertices, size_t vertexCount, const unsigned int* indices)
 {
 	glGenVertexArrays(1, &vao);
 	glBindVertexArray(vao);
@@ -29,10 +30,10 @@ void SubmeshData::build()
 	glGenBuffers(1, &ebo);
 
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(VertexData), &vertices[0], GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(VertexData), vertices, GL_STATIC_DRAW);
 
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, faces.size() * sizeof(unsigned int), &faces[0], GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
 
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)offsetof(VertexData, position));
 	glEnableVertexAttribArray(0);
@@ -74,17 +75,18 @@ void SubmeshData::dispose()
 void SubmeshData::setMaterialParams(Shader* shader)
 {
 	// set material params
+	const MaterialUniforms& uniforms = shader->getMaterialUniforms();
 	Glitter::Color diffuse = material.material->getParameterByName("diffuse")->color;
 	Glitter::Color ambient = material.material->getParameterByName("ambient")->color;
 	Glitter::Color specular = material.material->getParameterByName("specular")->color;
 	Glitter::Color emissive = material.material->getParameterByName("emissive")->color;
 	Glitter::Color powGloss = material.material->getParameterByName("power_gloss_level")->color;
 
-	shader->setVec4("material.diffuse", DirectX::XMVECTOR{ diffuse.r, diffuse.g, diffuse.b, diffuse.a });
-	shader->setVec4("material.ambient", DirectX::XMVECTOR{ ambient.r, ambient.g, ambient.b, ambient.a });
-	shader->setVec4("material.specular", DirectX::XMVECTOR{ specular.r, specular.g, specular.b, specular.a });
-	shader->setVec4("material.emissive", DirectX::XMVECTOR{ emissive.r, emissive.g, emissive.b, emissive.a });
-	shader->setVec4("material.power_gloss_level", DirectX::XMVECTOR{ powGloss.r, powGloss.g, powGloss.b, powGloss.a });
+	shader->set(uniforms.diffuse, DirectX::XMVECTOR{ diffuse.r, diffuse.g, diffuse.b, diffuse.a });
+	shader->set(uniforms.ambient, DirectX::XMVECTOR{ ambient.r, ambient.g, ambient.b, ambient.a });
+	shader->set(uniforms.specular, DirectX::XMVECTOR{ specular.r, specular.g, specular.b, specular.a });
+	shader->set(uniforms.emissive, DirectX::XMVECTOR{ emissive.r, emissive.g, emissive.b, emissive.a });
+	shader->set(uniforms.powerGlossLevel, DirectX::XMVECTOR{ powGloss.r, powGloss.g, powGloss.b, powGloss.a });
 
 	// set material flags
 	if (material.material->hasNoCulling())
@@ -97,91 +99,80 @@ void SubmeshData::setMaterialParams(Shader* shader)
 	}
 }
 
-void SubmeshData::appendVerticesTo(std::vector<VertexData>& list)
+void SubmeshData::bindInstanceBuffer(unsigned int buffer)
 {
-	list.insert(list.end(), vertices.begin(), vertices.end());
+	if (instanceBuffer == buffer)
+		return;
+
+	instanceBuffer = buffer;
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	// a mat4 attribute takes one location per column
+	for (unsigned int i = 0; i < 4; ++i)
+	{
+		glVertexAttribPointer(9 + i, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offsetof(InstanceData, model) + sizeof(float) * 4 * i));
+		glEnableVertexAttribArray(9 + i);
+		glVertexAttribDivisor(9 + i, 1);
+	}
+
+	glVertexAttribPointer(13, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(InstanceData), (void*)offsetof(InstanceData, color));
+	glEnableVertexAttribArray(13);
+	glVertexAttribDivisor(13, 1);
+
+	glVertexAttribPointer(14, 2, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offsetof(InstanceData, uvOffset));
+	glEnableVertexAttribArray(14);
+	glVertexAttribDivisor(14, 1);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
 }
 
-void SubmeshData::draw(Shader* shader, float time)
+void SubmeshData::bindMaterial(Shader* shader)
 {
-	// assign textures
-	unsigned int diffuseIndex = 0;
-	unsigned int glossIndex = 0;
-	unsigned int normalIndex = 0;
-	unsigned int emissiveIndex = 0;
-	unsigned int specularIndex = 0;
-	unsigned int reflectionIndex = 0;
-	unsigned int displacementIndex = 0;
+	static_assert((size_t)TextureSlot::SlotMax == materialTextureSlots, "every texture slot needs a material sampler");
+
+	// assign textures. sampler units are fixed per slot when the shader is linked
+	const MaterialUniforms& uniforms = shader->getMaterialUniforms();
+	std::array<bool, materialTextureSlots> bound{};
 	for (unsigned int i = 0; i < material.textures.size(); ++i)
 	{
-		glActiveTexture(GL_TEXTURE0 + i);
-
-		std::string samplerName;
-		std::string samplerNum;
-
 		std::shared_ptr<TextureData> &texture = material.textures[i];
 		Glitter::Texture* tex = material.material->getTextureByIndex(i);
 
-		switch (texture->getSlot())
-		{
-		case TextureSlot::Diffuse:
-			samplerNum = std::to_string(diffuseIndex++);
-			samplerName = "material.diffuse" + samplerNum;
-			shader->setInt("material.diffIndex", tex->getUVIndex());
-			break;
-
-		case TextureSlot::Gloss:
-			samplerNum = std::to_string(glossIndex++);
-			samplerName = "material.gloss" + samplerNum;
-			shader->setInt("material.glossIndex", tex->getUVIndex());
-			break;
-
-		case TextureSlot::Normal:
-			samplerNum = std::to_string(normalIndex++);
-			samplerName = "material.normal" + samplerNum;
-			shader->setInt("material.normIndex", tex->getUVIndex());
-			break;
-
-		case TextureSlot::Displacement:
-			samplerNum = std::to_string(displacementIndex++);
-			samplerName = "material.displacement" + samplerNum;
-			shader->setInt("material.disIndex", tex->getUVIndex());
-			break;
-
-		case TextureSlot::Emissive:
-			samplerNum = std::to_string(emissiveIndex++);
-			samplerName = "material.emissive" + samplerNum;
-			shader->setInt("material.emsIndex", tex->getUVIndex());
-			break;
-
-		case TextureSlot::Specular:
-			samplerNum = std::to_string(specularIndex++);
-			samplerName = "material.specular" + samplerNum;
-			shader->setInt("material.specIndex", tex->getUVIndex());
-			break;
-
-		case TextureSlot::Reflection:
-			samplerNum = std::to_string(reflectionIndex++);
-			samplerName = "material.reflection" + samplerNum;
-			shader->setInt("material.refIndex", tex->getUVIndex());
-			break;
-
-		default:
+		// the shader samples one texture per slot
+		size_t slot = (size_t)texture->getSlot();
+		if (slot >= materialTextureSlots || bound[slot])
 			continue;
-		}
 
-		shader->setInt(samplerName, i);
+		bound[slot] = true;
+		glActiveTexture(GL_TEXTURE0 + slot);
+		shader->set(uniforms.uvIndices[slot], tex->getUVIndex());
 		texture->setWrapMode(tex->getWrapModeU(), tex->getWrapModeV());
 		texture->use();
-
-		shader->setInt("material.hasNormal", normalIndex);
-		shader->setInt("material.hasGloss", glossIndex);
 	}
 
+	shader->set(uniforms.hasNormal, bound[(size_t)TextureSlot::Normal]);
+	shader->set(uniforms.hasGloss, bound[(size_t)TextureSlot::Gloss]);
+
 	setMaterialParams(shader);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void SubmeshData::draw(Shader* shader, float time)
+{
+	bindMaterial(shader);
 
 	// draw
-	glActiveTexture(GL_TEXTURE0);
 	glBindVertexArray(vao);
-	glDrawElements(GL_TRIANGLES, faces.size(), GL_UNSIGNED_INT, 0);
+	glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+}
+
+void SubmeshData::drawInstanced(Shader* shader, float time, unsigned int buffer, size_t count)
+{
+	bindMaterial(shader);
+	bindInstanceBuffer(buffer);
+
+	glBindVertexArray(vao);
+	glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, count);
 }
\ No newline at end of file
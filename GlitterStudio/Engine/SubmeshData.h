@@ -4,6 +4,7 @@
 #include "Shader.h"
 #include "Material.h"
 #include "UVAnimation.h"
+#include "..\Dependencies\DirectXMath-master\Inc\DirectXPackedVector.h"
 #include <memory>
 #include <vector>
 
@@ -23,6 +24,14 @@ struct VertexData
 	Glitter::Color color;
 };
 
+// per instance attributes for drawing the same submesh many times in one call
+struct InstanceData
+{
+	DirectX::XMFLOAT4X4 model;
+	DirectX::PackedVector::XMUBYTEN4 color;
+	DirectX::XMFLOAT2 uvOffset;
+};
+
 struct MaterialData
 {
 	std::shared_ptr<Glitter::Material> material;
@@ -32,22 +41,24 @@ struct MaterialData
 class SubmeshData
 {
 private:
-	std::vector<VertexData> vertices;
-	std::vector<unsigned int> faces;
+	size_t indexCount;
 	PirimitveType pirimitiveType;
 
 	unsigned int vao, vbo, ebo;
+	unsigned int instanceBuffer;
 
-	void build();
+	void build(const VertexData* vertices, size_t vertexCount, const unsigned int* indices);
 	void setMaterialParams(Shader* shader);
+	void bindMaterial(Shader* shader);
+	void bindInstanceBuffer(unsigned int buffer);
 
 public:
 	MaterialData material;
 
-	SubmeshData(const std::vector<VertexData> &v, const std::vector<unsigned int> &i, const MaterialData &mat, PirimitveType pirimitive);
+	SubmeshData(const VertexData* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, const MaterialData &mat, PirimitveType pirimitive);
 	~SubmeshData();
 
 	void dispose();
-	void appendVerticesTo(std::vector<VertexData>& list);
 	void draw(Shader* shader, float time);
+	void drawInstanced(Shader* shader, float time, unsigned int buffer, size_t count);
 };
\ No newline at end of file
@@ -2,17 +2,20 @@
 #include "Texture.h"
 #include "File.h"
 #include "BinaryReader.h"
+#include "TexturePacker.h"
 #include "../Logger.h"
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <gli/gli.hpp>
 
-TextureData::TextureData(const std::string& path, TextureSlot slot)
+TextureData::TextureData(const std::string& path, TextureSlot slot) :
+	arrayID{ 0 }, arrayLayer{ -1 }, packable{ false }
 {
 	reload(path, slot);
 }
 
-TextureData::TextureData()
+TextureData::TextureData() :
+	arrayID{ 0 }, arrayLayer{ -1 }, packable{ false }
 {
 
 }
@@ -47,6 +50,32 @@ int TextureData::getHeight() const
 	return height;
 }
 
+unsigned int TextureData::getArrayID() const
+{
+	return arrayID;
+}
+
+int TextureData::getArrayLayer() const
+{
+	return arrayLayer;
+}
+
+void TextureData::setArrayLayer(unsigned int array, int layer)
+{
+	arrayID = array;
+	arrayLayer = layer;
+}
+
+bool TextureData::isPackable() const
+{
+	return packable;
+}
+
+void TextureData::setPackable(bool val)
+{
+	packable = val;
+}
+
 unsigned int TextureData::glWrapMode(Glitter::TextureWrapMode mode)
 {
 	switch (mode)
@@ -81,6 +110,7 @@ void TextureData::setWrapMode(Glitter::TextureWrapMode u, Glitter::TextureWrapMo
 
 void TextureData::dispose()
 {
+	TexturePacker::unpack(this);
 	glDeleteTextures(1, &ID);
 }
 
@@ -92,6 +122,9 @@ bool TextureData::reload(const std::string& path, TextureSlot slot)
 		return false;
 	}
 
+	// the packed copy is stale once the file is read again
+	TexturePacker::unpack(this);
+
 	textureName = Glitter::File::getFileName(path);
 	fullname = path;
 	this->slot = slot;
@@ -142,4 +175,8 @@ void TextureData::read()
 			}
 
 	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// copy into a texture array while the decoded pixels are still around
+	if (packable)
+		TexturePacker::pack(this, tex);
 }
@@ -28,6 +28,9 @@ private:
 	bool hasAlpha;
 	int width;
 	int height;
+	unsigned int arrayID;
+	int arrayLayer;
+	bool packable;
 
 public:
 	TextureData();
@@ -39,6 +42,11 @@ public:
 	TextureSlot getSlot() const;
 	int getWidth() const;
 	int getHeight() const;
+	unsigned int getArrayID() const;
+	int getArrayLayer() const;
+	void setArrayLayer(unsigned int array, int layer);
+	bool isPackable() const;
+	void setPackable(bool val);
 
 	unsigned int glWrapMode(Glitter::TextureWrapMode mode);
 
@@ -0,0 +1,165 @@
+#include "TexturePacker.h"
+#include "../Logger.h"
+#include <glad/glad.h>
+#include <gli/gli.hpp>
+
+std::vector<TexturePage> TexturePacker::pages;
+
+bool TexturePacker::pack(TextureData* texture, const gli::texture& tex)
+{
+	if (texture->getArrayLayer() >= 0)
+		return true;
+
+	if (tex.empty() || tex.target() != gli::TARGET_2D)
+		return false;
+
+	gli::gl gl(gli::gl::PROFILE_GL33);
+	gli::gl::format const fmt = gl.translate(tex.format(), tex.swizzles());
+	bool compressed = gli::is_compressed(tex.format());
+
+	std::array<int, 4> swizzles{ fmt.Swizzles[0], fmt.Swizzles[1], fmt.Swizzles[2], fmt.Swizzles[3] };
+	int width = tex.extent().x;
+	int height = tex.extent().y;
+
+	TexturePage* page = nullptr;
+	size_t layer = 0;
+	for (TexturePage& p : pages)
+	{
+		if (p.width != width || p.height != height || p.levels != tex.levels() || p.internalFormat != fmt.Internal || p.swizzles != swizzles)
+			continue;
+
+		for (layer = 0; layer < texturePageLayers; ++layer)
+		{
+			if (!p.layers[layer])
+				break;
+		}
+
+		if (layer < texturePageLayers)
+		{
+			page = &p;
+			break;
+		}
+	}
+
+	if (!page)
+	{
+		TexturePage p;
+		p.width = width;
+		p.height = height;
+		p.levels = tex.levels();
+		p.internalFormat = fmt.Internal;
+		p.swizzles = swizzles;
+		p.layers.fill(nullptr);
+
+		glGenTextures(1, &p.ID);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, p.ID);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, p.levels - 1);
+
+		// wrapping is set per material by the renderer's samplers
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		for (int i = 0; i < 4; ++i)
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_SWIZZLE_R + i, swizzles[i]);
+
+		// allocate storage for every layer up front
+		for (size_t level = 0; level < p.levels; ++level)
+		{
+			gli::tvec3<GLsizei> extent(tex.extent(level));
+			if (compressed)
+				glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, fmt.Internal, extent.x, extent.y, texturePageLayers, 0, tex.size(level) * texturePageLayers, NULL);
+			else
+				glTexImage3D(GL_TEXTURE_2D_ARRAY, level, fmt.Internal, extent.x, extent.y, texturePageLayers, 0, fmt.External, fmt.Type, NULL);
+		}
+
+		pages.emplace_back(p);
+		page = &pages.back();
+		layer = 0;
+	}
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, page->ID);
+	for (size_t level = 0; level < page->levels; ++level)
+	{
+		gli::tvec3<GLsizei> extent(tex.extent(level));
+		if (compressed)
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, extent.x, extent.y, 1, fmt.Internal, tex.size(level), tex.data(0, 0, level));
+		else
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, extent.x, extent.y, 1, fmt.External, fmt.Type, tex.data(0, 0, level));
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	page->layers[layer] = texture;
+	texture->setArrayLayer(page->ID, layer);
+
+	return true;
+}
+
+void TexturePacker::unpack(TextureData* texture)
+{
+	if (texture->getArrayLayer() < 0)
+		return;
+
+	for (std::vector<TexturePage>::iterator it = pages.begin(); it != pages.end(); ++it)
+	{
+		if (it->ID != texture->getArrayID())
+			continue;
+
+		it->layers[texture->getArrayLayer()] = nullptr;
+		texture->setArrayLayer(0, -1);
+
+		bool empty = true;
+		for (TextureData* t : it->layers)
+		{
+			if (t)
+			{
+				empty = false;
+				break;
+			}
+		}
+
+		if (empty)
+		{
+			glDeleteTextures(1, &it->ID);
+			pages.erase(it);
+		}
+
+		return;
+	}
+}
+
+void TexturePacker::disposeAll()
+{
+	for (TexturePage& page : pages)
+	{
+		for (TextureData* t : page.layers)
+		{
+			if (t)
+				t->setArrayLayer(0, -1);
+		}
+
+		glDeleteTextures(1, &page.ID);
+	}
+
+	pages.clear();
+}
+
+size_t TexturePacker::getPageCount()
+{
+	return pages.size();
+}
+
+size_t TexturePacker::getLayerCount()
+{
+	size_t count = 0;
+	for (const TexturePage& page : pages)
+	{
+		for (TextureData* t : page.layers)
+		{
+			if (t)
+				++count;
+		}
+	}
+
+	return count;
+}
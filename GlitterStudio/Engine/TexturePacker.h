@@ -0,0 +1,41 @@
+#pragma once
+#include "TextureData.h"
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace gli
+{
+	class texture;
+}
+
+constexpr size_t texturePageLayers = 8;
+
+struct TexturePage
+{
+	unsigned int ID;
+	int width;
+	int height;
+	size_t levels;
+	unsigned int internalFormat;
+	std::array<int, 4> swizzles;
+	std::array<TextureData*, texturePageLayers> layers;
+};
+
+/// <summary>
+/// Copies particle textures with matching size and format into layers of shared 2D texture arrays,
+/// so particles using different materials can be drawn in the same batch.
+/// </summary>
+class TexturePacker
+{
+private:
+	static std::vector<TexturePage> pages;
+
+public:
+	static bool pack(TextureData* texture, const gli::texture& tex);
+	static void unpack(TextureData* texture);
+	static void disposeAll();
+
+	static size_t getPageCount();
+	static size_t getLayerCount();
+};
@@ -23,6 +23,9 @@ namespace Glitter
 			case FileType::Texture:
 				return "Texture";
 
+			case FileType::Capture:
+				return "Simulation Capture";
+
 			default:
 				return "File";
 			}
@@ -44,6 +47,9 @@ namespace Glitter
 			case FileType::Texture:
 				return "Texture(.dds)\0*.dds\0";
 
+			case FileType::Capture:
+				return "Simulation Capture(.gcap)\0*.gcap\0";
+
 			default:
 				return "All files\0*.*\0";
 			}
@@ -61,6 +67,8 @@ namespace Glitter
 				return ".model";
 			case Glitter::Editor::FileType::Texture:
 				return ".dds";
+			case Glitter::Editor::FileType::Capture:
+				return ".gcap";
 			default:
 				return "";
 			}
@@ -11,7 +11,8 @@ namespace Glitter
 			Effect,
 			Material,
 			Model,
-			Texture
+			Texture,
+			Capture
 		};
 
 		class FileDialog
@@ -5,6 +5,8 @@
 #include "File.h"
 #include "UI.h"
 #include "UiHelper.h"
+#include "FileDialog.h"
+#include "Logger.h"
 
 namespace Glitter
 {
@@ -35,14 +37,40 @@ namespace Glitter
 
 			if (selectedEffect)
 				selectedEffect->kill();
+
+			if (capture)
+				capture->rewind();
 		}
 
 		void GlitterPlayer::replay()
 		{
 			stopPlayback();
+			seek(0.0f);
 			togglePlayback();
 		}
 
+		void GlitterPlayer::seek(float target)
+		{
+			if (!selectedEffect || capture)
+				return;
+
+			// restore the closest checkpoint before the target and simulate the rest of the way at preview frame rate
+			float from = checkpoints.restore(target, selectedEffect);
+			if (from < 0.0f)
+			{
+				selectedEffect->kill();
+				from = 0.0f;
+			}
+
+			for (float t = from; t < target; t += 1.0f)
+			{
+				ParticleBudget::beginFrame();
+				selectedEffect->update(t, viewport.getCamera(), culling);
+			}
+
+			time = target;
+		}
+
 		bool GlitterPlayer::isPlaying()
 		{
 			return playing;
@@ -57,6 +85,11 @@ namespace Glitter
 		{
 			if (node != selectedEffect)
 			{
+				// captures are tied to the effect they were recorded from
+				recorder.reset();
+				capture.reset();
+				checkpoints.clear();
+
 				selectedEffect = node;
 				stopPlayback();
 				
@@ -76,22 +109,52 @@ namespace Glitter
 		void GlitterPlayer::updatePreview(Renderer* renderer, float deltaT)
 		{
 			viewport.use();
+			renderer->beginFrame(viewport);
 
 			if (drawGrid)
 				renderer->drawGrid(viewport);
 
 			if (selectedEffect)
 			{
-				// give extra time for if some particles are still alive
-				maxTime = selectedEffect->getEffect()->getStartTime() + selectedEffect->getEffect()->getLifeTime() + 60.0f;
-				if (time > maxTime && !isEffectLoop())
+				if (capture)
 				{
-					stopPlayback();
-					if (loop)
-						togglePlayback();
+					// feed the renderer from the capture instead of simulating
+					if (playing && !capture->nextFrame(selectedEffect))
+					{
+						// a capture that fails to read mid playback is closed instead of looping over it
+						if (!capture->valid())
+							capture.reset();
+
+						stopPlayback();
+						if (loop && capture)
+							togglePlayback();
+					}
+				}
+				else
+				{
+					// give extra time for if some particles are still alive
+					maxTime = selectedEffect->getEffect()->getStartTime() + selectedEffect->getEffect()->getLifeTime() + 60.0f;
+					if (time > maxTime && !isEffectLoop())
+					{
+						if (loop)
+							seek(0.0f);
+						else
+							stopPlayback();
+					}
+
+					Vector2 size = viewport.getSize();
+					culling.update(viewport.getCamera(), size.y > 0.0f ? size.x / size.y : 0.0f);
+
+					if (playing)
+						checkpoints.update(time, selectedEffect);
+
+					ParticleBudget::beginFrame();
+					selectedEffect->update(time, viewport.getCamera(), culling);
+
+					if (recorder && playing)
+						recorder->recordFrame(time, selectedEffect);
 				}
 
-				selectedEffect->update(time, viewport.getCamera());
 				time += deltaT * 60.0f * playbackSpeed * playing;
 
 				renderer->drawEffect(selectedEffect, viewport);
@@ -100,6 +163,44 @@ namespace Glitter
 			viewport.end();
 		}
 
+		void GlitterPlayer::captureMenu()
+		{
+			ImGui::Separator();
+			if (ImGui::MenuItem(recorder ? "Stop Recording" : "Record Capture...", NULL, false, selectedEffect && !capture))
+			{
+				std::string path;
+				if (recorder)
+				{
+					Logger::log(Message(MessageType::Normal, "Recorded " + std::to_string(recorder->getFrameCount()) + " frames."));
+					recorder.reset();
+				}
+				else if (FileDialog::saveFileDialog(FileType::Capture, path))
+				{
+					recorder = std::make_unique<CaptureRecorder>(path, selectedEffect);
+					if (!recorder->valid())
+						recorder.reset();
+				}
+			}
+
+			if (ImGui::MenuItem(capture ? "Close Capture" : "Play Capture...", NULL, false, selectedEffect && !recorder))
+			{
+				std::string path;
+				if (capture)
+				{
+					capture.reset();
+					stopPlayback();
+				}
+				else if (FileDialog::openFileDialog(FileType::Capture, path))
+				{
+					capture = std::make_unique<CapturePlayer>(path, selectedEffect);
+					if (capture->valid())
+						replay();
+					else
+						capture.reset();
+				}
+			}
+		}
+
 		void GlitterPlayer::update(Renderer* renderer, float deltaT)
 		{
 			if (ImGui::Begin(UI::gPlayerWindow, NULL, ImGuiWindowFlags_NoBringToFrontOnFocus | ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse))
@@ -141,6 +242,12 @@ namespace Glitter
 				ImGui::SameLine();
 				ImGui::Checkbox("Loop", &loop);
 
+				ImGui::SameLine();
+				ImGui::SetNextItemWidth(200);
+				float seekTime = time;
+				if (ImGui::SliderFloat("Time", &seekTime, 0.0f, maxTime, "%.0f") && !capture)
+					seek(seekTime);
+
 				ImGui::SameLine();
 				ImGui::SeparatorEx(ImGuiSeparatorFlags_Vertical);
 				ImGui::SameLine();
@@ -160,6 +267,30 @@ namespace Glitter
 					if (ImGui::MenuItem("Replay"))
 						replay();
 
+					ImGui::Separator();
+					if (ImGui::MenuItem("Frustum Culling", NULL, culling.isFrustumCulling()))
+						culling.setFrustumCulling(!culling.isFrustumCulling());
+
+					if (ImGui::MenuItem("Cull Simulation", NULL, culling.isSimulationCulling(), culling.isFrustumCulling()))
+						culling.setSimulationCulling(!culling.isSimulationCulling());
+
+					if (ImGui::MenuItem("Distance LOD", NULL, culling.isDistanceLod()))
+						culling.setDistanceLod(!culling.isDistanceLod());
+
+					captureMenu();
+
+					if (ImGui::BeginMenu("Effect Priority", selectedEffect != nullptr))
+					{
+						for (size_t i = 0; i < budgetPriorityTableSize; ++i)
+						{
+							BudgetPriority p = (BudgetPriority)i;
+							if (ImGui::MenuItem(budgetPriorityTable[i].c_str(), NULL, selectedEffect->getPriority() == p))
+								selectedEffect->setPriority(p);
+						}
+
+						ImGui::EndMenu();
+					}
+
 					ImGui::EndMenu();
 				}
 				ImGui::EndMainMenuBar();
@@ -1,6 +1,9 @@
 #pragma once
 #include "Viewport.h"
 #include "EffectNode.h"
+#include "ParticleCulling.h"
+#include "SimulationCapture.h"
+#include "SimulationCheckpoint.h"
 
 class Renderer;
 
@@ -20,8 +23,13 @@ namespace Glitter
 			bool playOnSelect;
 			EffectNode* selectedEffect;
 			Viewport viewport;
+			ParticleCulling culling;
+			std::unique_ptr<CaptureRecorder> recorder;
+			std::unique_ptr<CapturePlayer> capture;
+			CheckpointManager checkpoints;
 
 			void updatePreview(Renderer* renderer, float deltaT);
+			void captureMenu();
 
 		public:
 			GlitterPlayer();
@@ -31,6 +39,7 @@ namespace Glitter
 			void togglePlayback();
 			void stopPlayback();
 			void replay();
+			void seek(float target);
 			bool isPlaying();
 			bool isLoop();
 			void setEffect(EffectNode* node);
@@ -3,6 +3,7 @@
 #include "File.h"
 #include "FileDialog.h"
 #include "ResourceManager.h"
+#include <algorithm>
 
 namespace Glitter
 {
@@ -17,7 +18,7 @@ namespace Glitter
 
 			if (mat->getTexture().size())
 			{
-				ResourceManager::loadTexture(filename, TextureSlot::Diffuse);
+				ResourceManager::loadTexture(filename, TextureSlot::Diffuse, true);
 				changeTexture(ResourceManager::getTexture(File::getFileName(filename)));
 			}
 		}
@@ -39,6 +40,58 @@ namespace Glitter
 			return texture;
 		}
 
+		void MaterialNode::buildUVFrames(int columns, int rows, int width, int height)
+		{
+			uvFrames.frames.clear();
+			uvFrames.frames.reserve((size_t)columns * rows);
+
+			// cells are whole texels wide, so any remainder at the right and bottom edges is left out
+			int cellWidth = width / columns;
+			int cellHeight = height / rows;
+			for (int row = 0; row < rows; ++row)
+			{
+				for (int column = 0; column < columns; ++column)
+				{
+					UVFrame frame;
+					frame.left = (float)(column * cellWidth) / width;
+					frame.right = (float)((column + 1) * cellWidth) / width;
+					frame.top = (float)(row * cellHeight) / height;
+					frame.bottom = (float)((row + 1) * cellHeight) / height;
+					uvFrames.frames.emplace_back(frame);
+				}
+			}
+
+			uvFrames.columns = columns;
+			uvFrames.rows = rows;
+			uvFrames.width = width;
+			uvFrames.height = height;
+			++uvFrames.version;
+		}
+
+		const UVFrameTable& MaterialNode::getUVFrames()
+		{
+			Vector2 split = material->getSplit();
+			int columns = std::max((int)split.x, 1);
+			int rows = std::max((int)split.y, 1);
+			int width = texture ? texture->getWidth() : 0;
+			int height = texture ? texture->getHeight() : 0;
+
+			if (!uvFrames.version || columns != uvFrames.columns || rows != uvFrames.rows ||
+				width != uvFrames.width || height != uvFrames.height)
+			{
+				if (width && height)
+					buildUVFrames(columns, rows, width, height);
+			}
+
+			return uvFrames;
+		}
+
+		size_t MaterialNode::getUVFrameCount() const
+		{
+			Vector2 split = material->getSplit();
+			return (size_t)std::max((int)split.x, 1) * std::max((int)split.y, 1);
+		}
+
 		NodeType MaterialNode::getNodeType()
 		{
 			return NodeType::GTMaterial;
@@ -47,7 +100,10 @@ namespace Glitter
 		void MaterialNode::changeTexture(std::shared_ptr<TextureData> tex)
 		{
 			texture = tex;
-			if (tex) material->setTexture(File::getFileNameWithoutExtension(tex->getName()));
+			if (tex)
+			{
+				material->setTexture(File::getFileNameWithoutExtension(tex->getName()));
+			}
 		}
 
 		void MaterialNode::populateInspector()
@@ -72,7 +128,7 @@ namespace Glitter
 					std::string name;
 					if (FileDialog::openFileDialog(FileType::Texture, name))
 					{
-						ResourceManager::loadTexture(name, TextureSlot::Diffuse);
+						ResourceManager::loadTexture(name, TextureSlot::Diffuse, true);
 						changeTexture(ResourceManager::getTexture(File::getFileName(name)));
 					}
 				}
@@ -2,16 +2,40 @@
 #include "INode.h"
 #include "GlitterMaterial.h"
 #include "TextureData.h"
+#include <vector>
 
 namespace Glitter
 {
 	namespace Editor
 	{
+		// texture space rect of a single split cell
+		struct UVFrame
+		{
+			float left;
+			float top;
+			float right;
+			float bottom;
+		};
+
+		// split cells of a material, rebuilt only when the split or the texture size changes
+		struct UVFrameTable
+		{
+			std::vector<UVFrame> frames;
+			int columns = 0;
+			int rows = 0;
+			int width = 0;
+			int height = 0;
+			unsigned int version = 0;
+		};
+
 		class MaterialNode : public INode
 		{
 		private:
 			std::shared_ptr<GlitterMaterial> material;
 			std::shared_ptr<TextureData> texture;
+			UVFrameTable uvFrames;
+
+			void buildUVFrames(int columns, int rows, int width, int height);
 
 		public:
 			MaterialNode(std::shared_ptr<GlitterMaterial>& mat);
@@ -20,6 +44,8 @@ namespace Glitter
 			std::shared_ptr<GlitterMaterial> getMaterial();
 			std::shared_ptr<TextureData> getTexture();
 			void changeTexture(std::shared_ptr<TextureData> tex);
+			const UVFrameTable& getUVFrames();
+			size_t getUVFrameCount() const;
 
 			virtual NodeType getNodeType() override;
 			virtual void populateInspector() override;
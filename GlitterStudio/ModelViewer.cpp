@@ -84,6 +84,7 @@ namespace Glitter
 		void ModelViewer::updatePreview(Renderer* renderer, float deltaT)
 		{
 			viewport.use();
+			renderer->beginFrame(viewport);
 
 			if (drawGrid)
 				renderer->drawGrid(viewport);
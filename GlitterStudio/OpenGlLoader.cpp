@@ -26,6 +26,11 @@ namespace Glitter
 			stbi_image_free(images[0].pixels);
 		}
 
+		void Application::showError(const std::string& message)
+		{
+			MessageBox(NULL, message.c_str(), "Glitter Studio", MB_OK | MB_ICONERROR);
+		}
+
 		bool Application::initOpenGL()
 		{
 			// GLFW initializion
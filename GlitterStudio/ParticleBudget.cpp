@@ -0,0 +1,171 @@
+#include "ParticleBudget.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace Glitter
+{
+	namespace Editor
+	{
+		size_t ParticleBudget::budget = 20000;
+		size_t ParticleBudget::live = 0;
+		size_t ParticleBudget::reported = 0;
+		size_t ParticleBudget::unreserved = 0;
+		size_t ParticleBudget::frame = 0;
+		float ParticleBudget::falloffDistance = 50.0f;
+		bool ParticleBudget::enabled = true;
+		BudgetStats ParticleBudget::frameStats;
+		BudgetStats ParticleBudget::lastStats;
+		std::unordered_map<const void*, BudgetShare> ParticleBudget::shares;
+
+		// share of the budget each priority may fill before its emission gets throttled
+		static const float priorityThresholds[] = { 0.75f, 0.9f, 1.0f };
+
+		// relative size of each priority's reservation in the fair split
+		static const float priorityWeights[] = { 1.0f, 2.0f, 4.0f };
+
+		// emitters that haven't requested for this many frames are forgotten
+		constexpr size_t shareLifetime = 300;
+
+		void ParticleBudget::beginFrame()
+		{
+			frameStats.live = reported;
+			frameStats.budget = budget;
+			lastStats = frameStats;
+
+			frameStats = BudgetStats();
+			live = reported;
+			reported = 0;
+			++frame;
+
+			distributeHeadroom();
+		}
+
+		void ParticleBudget::distributeHeadroom()
+		{
+			std::vector<BudgetShare*> active;
+			active.reserve(shares.size());
+
+			float totalWeight = 0.0f;
+			for (auto it = shares.begin(); it != shares.end();)
+			{
+				if (frame - it->second.lastFrame > shareLifetime)
+				{
+					it = shares.erase(it);
+					continue;
+				}
+
+				it->second.quota = 0;
+				if (it->second.demand)
+				{
+					active.push_back(&it->second);
+					totalWeight += it->second.weight;
+				}
+
+				++it;
+			}
+
+			// water filling: emitters asking for less than their weighted share get all of it,
+			// and what they leave is split between the rest
+			std::sort(active.begin(), active.end(), [](const BudgetShare* a, const BudgetShare* b)
+			{
+				return a->demand * b->weight < b->demand * a->weight;
+			});
+
+			size_t remaining = budget > live ? budget - live : 0;
+			for (BudgetShare* share : active)
+			{
+				if (totalWeight <= 0.0f)
+					break;
+
+				size_t fair = (size_t)(remaining * (share->weight / totalWeight));
+				share->quota = std::min(share->demand, fair);
+				remaining -= share->quota;
+				totalWeight -= share->weight;
+			}
+
+			// only emitters that request again this frame are reserved a share in the next one
+			for (BudgetShare* share : active)
+				share->demand = 0;
+
+			unreserved = remaining;
+			frameStats.requesters = active.size();
+		}
+
+		void ParticleBudget::report(size_t alive)
+		{
+			reported += alive;
+		}
+
+		int ParticleBudget::request(const void* requester, int count, BudgetPriority priority, float distance)
+		{
+			if (count <= 0)
+				return 0;
+
+			frameStats.requested += count;
+
+			// distant emitters get a smaller share
+			BudgetShare& share = shares[requester];
+			share.weight = priorityWeights[(size_t)priority] / (1.0f + std::max(distance, 0.0f) / falloffDistance);
+			share.demand = count;
+			share.lastFrame = frame;
+
+			size_t granted = count;
+			if (enabled)
+			{
+				size_t limit = (size_t)(budget * priorityThresholds[(size_t)priority]);
+				size_t headroom = live < limit ? limit - live : 0;
+
+				// the emitter's own reservation first, then whatever nobody has reserved
+				size_t fromQuota = std::min(granted, share.quota);
+				size_t fromPool = std::min(granted - fromQuota, unreserved);
+				granted = std::min(fromQuota + fromPool, headroom);
+
+				size_t usedQuota = std::min(granted, share.quota);
+				share.quota -= usedQuota;
+				unreserved -= granted - usedQuota;
+
+				if (granted < (size_t)count)
+					++frameStats.throttled;
+			}
+
+			live += granted;
+			frameStats.granted += granted;
+			return (int)granted;
+		}
+
+		void ParticleBudget::release(size_t count)
+		{
+			count = std::min(count, live);
+			live -= count;
+
+			size_t headroom = budget > live ? budget - live : 0;
+			unreserved = std::min(unreserved + count, headroom);
+		}
+
+		void ParticleBudget::setBudget(size_t count)
+		{
+			budget = count;
+		}
+
+		void ParticleBudget::setEnabled(bool val)
+		{
+			enabled = val;
+		}
+
+		size_t ParticleBudget::getBudget()
+		{
+			return budget;
+		}
+
+		bool ParticleBudget::isEnabled()
+		{
+			return enabled;
+		}
+
+		const BudgetStats& ParticleBudget::getStats()
+		{
+			return lastStats;
+		}
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+
+namespace Glitter
+{
+	namespace Editor
+	{
+		enum class BudgetPriority
+		{
+			Low,
+			Normal,
+			High
+		};
+
+		const size_t budgetPriorityTableSize = 3;
+		const std::string budgetPriorityTable[] =
+		{
+			"Low",
+			"Normal",
+			"High"
+		};
+
+		struct BudgetStats
+		{
+			size_t budget = 0;
+			size_t live = 0;
+			size_t requested = 0;
+			size_t granted = 0;
+			size_t throttled = 0;
+			size_t requesters = 0;
+		};
+
+		// an emitter's standing in the fair split, carried across frames
+		struct BudgetShare
+		{
+			float weight = 0.0f;
+			size_t demand = 0;
+			size_t quota = 0;
+			size_t lastFrame = 0;
+		};
+
+		/// <summary>
+		/// Caps the number of live particles across all simulated instances by throttling emission
+		/// once usage passes a priority dependent share of the budget.
+		/// Every emitter that requested on the previous frame is reserved a share of the frame's headroom, weighted by priority and distance,
+		/// so emitters updated first can't starve the rest. Dying particles hand their budget back straight away.
+		/// </summary>
+		class ParticleBudget
+		{
+		private:
+			static size_t budget;
+			static size_t live;
+			static size_t reported;
+			static size_t unreserved;
+			static size_t frame;
+			static float falloffDistance;
+			static bool enabled;
+			static BudgetStats frameStats;
+			static BudgetStats lastStats;
+			static std::unordered_map<const void*, BudgetShare> shares;
+
+			static void distributeHeadroom();
+
+		public:
+			static void beginFrame();
+			static void report(size_t alive);
+			static int request(const void* requester, int count, BudgetPriority priority, float distance);
+			static void release(size_t count);
+
+			static void setBudget(size_t count);
+			static void setEnabled(bool val);
+			static size_t getBudget();
+			static bool isEnabled();
+			static const BudgetStats& getStats();
+		};
+	}
+}
@@ -0,0 +1,89 @@
+#include "ParticleCulling.h"
+#include <algorithm>
+
+namespace Glitter
+{
+	namespace Editor
+	{
+		ParticleCulling::ParticleCulling() :
+			frustumCulling{ true }, simulationCulling{ false }, distanceLod{ false }, valid{ false },
+			lodNear{ 10.0f }, lodFar{ 100.0f }, lodMinScale{ 0.25f }
+		{
+			eye = DirectX::XMVECTOR{ 0.0f, 0.0f, 0.0f, 1.0f };
+		}
+
+		void ParticleCulling::update(const Camera& camera, float aspect)
+		{
+			// nothing to test against until the viewport has a size
+			valid = aspect > 0.0f;
+			if (!valid)
+				return;
+
+			DirectX::BoundingFrustum viewFrustum(camera.getProjectionMatrix(aspect), true);
+			viewFrustum.Transform(frustum, DirectX::XMMatrixInverse(nullptr, camera.getViewMatrix()));
+			eye = camera.getPosition();
+		}
+
+		bool ParticleCulling::isVisible(const DirectX::BoundingBox& bounds) const
+		{
+			if (!frustumCulling || !valid)
+				return true;
+
+			return frustum.Contains(bounds) != DirectX::DISJOINT;
+		}
+
+		float ParticleCulling::getDistance(const DirectX::XMVECTOR& position) const
+		{
+			return DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(position, eye)));
+		}
+
+		float ParticleCulling::getEmissionScale(const DirectX::XMVECTOR& position) const
+		{
+			if (!distanceLod)
+				return 1.0f;
+
+			float distance = getDistance(position);
+			if (lodFunction)
+				return std::clamp(lodFunction(distance), 0.0f, 1.0f);
+
+			// default to a linear falloff between lodNear and lodFar
+			float t = std::clamp((distance - lodNear) / (lodFar - lodNear), 0.0f, 1.0f);
+			return 1.0f - (t * (1.0f - lodMinScale));
+		}
+
+		void ParticleCulling::setLodFunction(LodFunction func)
+		{
+			lodFunction = func;
+		}
+
+		void ParticleCulling::setFrustumCulling(bool val)
+		{
+			frustumCulling = val;
+		}
+
+		void ParticleCulling::setSimulationCulling(bool val)
+		{
+			simulationCulling = val;
+		}
+
+		void ParticleCulling::setDistanceLod(bool val)
+		{
+			distanceLod = val;
+		}
+
+		bool ParticleCulling::isFrustumCulling() const
+		{
+			return frustumCulling;
+		}
+
+		bool ParticleCulling::isSimulationCulling() const
+		{
+			return simulationCulling;
+		}
+
+		bool ParticleCulling::isDistanceLod() const
+		{
+			return distanceLod;
+		}
+	}
+}
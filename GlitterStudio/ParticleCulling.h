@@ -0,0 +1,44 @@
+#pragma once
+#include "Camera.h"
+#include "..\Dependencies\DirectXMath-master\Inc\DirectXCollision.h"
+#include <functional>
+
+namespace Glitter
+{
+	namespace Editor
+	{
+		// returns an emission rate multiplier for an emitter at the given distance from the camera
+		using LodFunction = std::function<float(float distance)>;
+
+		class ParticleCulling
+		{
+		private:
+			DirectX::BoundingFrustum frustum;
+			DirectX::XMVECTOR eye;
+			LodFunction lodFunction;
+			bool frustumCulling;
+			bool simulationCulling;
+			bool distanceLod;
+			bool valid;
+			float lodNear;
+			float lodFar;
+			float lodMinScale;
+
+		public:
+			ParticleCulling();
+
+			void update(const Camera& camera, float aspect);
+			bool isVisible(const DirectX::BoundingBox& bounds) const;
+			float getDistance(const DirectX::XMVECTOR& position) const;
+			float getEmissionScale(const DirectX::XMVECTOR& position) const;
+			void setLodFunction(LodFunction func);
+
+			void setFrustumCulling(bool val);
+			void setSimulationCulling(bool val);
+			void setDistanceLod(bool val);
+			bool isFrustumCulling() const;
+			bool isSimulationCulling() const;
+			bool isDistanceLod() const;
+		};
+	}
+}
@@ -1,13 +1,15 @@
 #include "ParticleInstance.h"
+#include "EmitterNode.h"
 #include "Utilities.h"
 #include "MathExtensions.h"
+#include <cfloat>
 
 namespace Glitter
 {
 	namespace Editor
 	{
 		ParticleInstance::ParticleInstance(std::weak_ptr<ParticleNode> nodeRef) :
-			reference{ nodeRef }, aliveCount{ 0 }, rotationAddCount{ 0 }, visible{ true }
+			reference{ nodeRef }, aliveCount{ 0 }, animationRevision{ 0 }, rotationAddCount{ 0 }, visible{ true }, culled{ false }, childrenPrepared{ false }
 		{
 			size_t count = reference->getParticle()->getMaxCount();
 			pool.reserve(count);
@@ -61,11 +63,191 @@ namespace Glitter
 
 		void ParticleInstance::kill()
 		{
+			size_t alive = 0;
 			for (auto& p : pool)
 			{
+				alive += !p.dead;
 				p.locusHistories.clear();
 				p.dead = true;
 			}
+
+			ParticleBudget::release(alive);
+
+			killChildEmitters();
+		}
+
+		void ParticleInstance::prepareChildEmitters(const std::vector<std::shared_ptr<EmitterNode>>& emitters, int depth)
+		{
+			childPools.clear();
+			childrenPrepared = true;
+
+			if (depth >= maxChildEmitterDepth)
+				return;
+
+			size_t capacity = std::min((size_t)getParticle()->getMaxCount(), maxChildEmitterInstances >> (depth * 2));
+			for (auto& child : getParticle()->getChildEmitters())
+			{
+				std::shared_ptr<Emitter> childEmitter = child.lock();
+				for (auto& node : emitters)
+				{
+					if (node->getEmitter() != childEmitter)
+						continue;
+
+					ChildEmitterPool childPool;
+					childPool.instances.resize(capacity);
+					for (ChildEmitter& instance : childPool.instances)
+						instance.node = std::make_shared<EmitterNode>(*node, emitters, depth + 1);
+
+					childPools.emplace_back(std::move(childPool));
+					break;
+				}
+			}
+		}
+
+		void ParticleInstance::updateChildEmitters(float time, const Camera& camera, const ParticleCulling& culling, BudgetPriority priority, const Quaternion& emRot)
+		{
+			if (childPools.empty())
+				return;
+
+			float childTime = getParticle()->getChildEmitterTime();
+			for (size_t slot = 0; slot < pool.size(); ++slot)
+			{
+				ParticleStatus& p = pool[slot];
+				if (p.dead || p.childSpawned || p.time < childTime)
+					continue;
+
+				p.childSpawned = true;
+				for (ChildEmitterPool& childPool : childPools)
+				{
+					// bursts beyond the pool's capacity are dropped
+					auto it = std::find_if(childPool.instances.begin(), childPool.instances.end(),
+						[](const ChildEmitter& c) { return !c.active; });
+
+					if (it == childPool.instances.end())
+						continue;
+
+					it->active = true;
+					it->parentSlot = slot;
+					it->parentStartTime = p.startTime;
+					it->spawnTime = p.startTime + childTime;
+					it->origin = p.mat4.r[3];
+					it->node->kill();
+					it->node->resetEmission();
+					++childPool.activeCount;
+				}
+			}
+
+			for (ChildEmitterPool& childPool : childPools)
+			{
+				if (!childPool.activeCount)
+					continue;
+
+				for (ChildEmitter& child : childPool.instances)
+				{
+					if (!child.active)
+						continue;
+
+					// follow the parent particle for as long as it lives
+					bool parentAlive = child.parentSlot < pool.size() && !pool[child.parentSlot].dead &&
+						pool[child.parentSlot].startTime == child.parentStartTime;
+
+					if (parentAlive)
+						child.origin = pool[child.parentSlot].mat4.r[3];
+
+					float t = time - child.spawnTime;
+					std::shared_ptr<Emitter> emitter = child.node->getEmitter();
+					child.node->update(t, t, camera, culling, priority, DirectX::XMMatrixTranslationFromVector(child.origin), emRot);
+
+					bool emitting = (t - emitter->getStartTime() <= emitter->getLifeTime()) || ((emitter->getFlags() & 1) && parentAlive);
+					if (!emitting && !child.node->isAlive())
+					{
+						child.active = false;
+						--childPool.activeCount;
+					}
+				}
+			}
+		}
+
+		void ParticleInstance::killChildEmitters()
+		{
+			for (ChildEmitterPool& childPool : childPools)
+			{
+				for (ChildEmitter& child : childPool.instances)
+				{
+					if (child.active)
+						child.node->kill();
+
+					child.active = false;
+				}
+
+				childPool.activeCount = 0;
+			}
+		}
+
+		void ParticleInstance::clearChildEmitters()
+		{
+			childPools.clear();
+			childrenPrepared = false;
+		}
+
+		bool ParticleInstance::isChildEmittersPrepared() const
+		{
+			return childrenPrepared;
+		}
+
+		bool ParticleInstance::hasActiveChildEmitters() const
+		{
+			for (const ChildEmitterPool& childPool : childPools)
+			{
+				if (childPool.activeCount)
+					return true;
+			}
+
+			return false;
+		}
+
+		std::vector<ChildEmitterPool>& ParticleInstance::getChildEmitters()
+		{
+			return childPools;
+		}
+
+		ParticleInstanceState ParticleInstance::saveState() const
+		{
+			ParticleInstanceState state;
+			state.rotationAddCount = rotationAddCount;
+			state.pool.reserve(pool.size());
+
+			for (const ParticleStatus& p : pool)
+			{
+				if (p.dead)
+				{
+					state.pool.emplace_back();
+					continue;
+				}
+
+				state.pool.push_back(p);
+				state.pool.back().animation = CachedAnimation();
+			}
+
+			return state;
+		}
+
+		void ParticleInstance::restoreState(const ParticleInstanceState& state)
+		{
+			pool = state.pool;
+			rotationAddCount = state.rotationAddCount;
+			culled = false;
+
+			// child emitters aren't part of the state. respawn them from the restored particles
+			killChildEmitters();
+			for (ParticleStatus& p : pool)
+			{
+				p.childSpawned = false;
+				if (!p.dead)
+					p.animation.buildCache(reference->getAnimationSet());
+			}
+
+			animationRevision = reference->getAnimationSet()->getRevision();
 		}
 
 		void ParticleInstance::setVisible(bool val)
@@ -78,6 +260,21 @@ namespace Glitter
 			return visible;
 		}
 
+		bool ParticleInstance::isCulled() const
+		{
+			return culled;
+		}
+
+		void ParticleInstance::setCulled(bool val)
+		{
+			culled = val;
+		}
+
+		const DirectX::BoundingBox& ParticleInstance::getBounds() const
+		{
+			return bounds;
+		}
+
 		Vector3 ParticleInstance::getAnchorPoint(PivotPosition pivot)
 		{
 			switch (pivot)
@@ -151,10 +348,195 @@ namespace Glitter
 			}
 		}
 
-		void ParticleInstance::update(float time, const Camera& camera, const DirectX::XMMATRIX &emM4, const Quaternion &emRot)
+		// earliest time in (0, maxTime] at which h + v*t + a*t^2 reaches zero while moving downwards
+		static bool findPlaneCrossing(float h, float v, float a, float maxTime, float& t)
+		{
+			const float epsilon = 0.0001f;
+			float roots[2];
+			int count = 0;
+
+			if (fabsf(a) < 0.00000001f)
+			{
+				if (fabsf(v) > 0.00000001f)
+					roots[count++] = -h / v;
+			}
+			else
+			{
+				float discriminant = v * v - 4.0f * a * h;
+				if (discriminant < 0.0f)
+					return false;
+
+				float q = -0.5f * (v + copysignf(sqrtf(discriminant), v));
+				roots[count++] = q / a;
+				if (q != 0.0f)
+					roots[count++] = h / q;
+			}
+
+			bool found = false;
+			t = maxTime;
+			for (int i = 0; i < count; ++i)
+			{
+				if (roots[i] > epsilon && roots[i] <= t && (v + 2.0f * a * roots[i]) < 0.0f)
+				{
+					t = roots[i];
+					found = true;
+				}
+			}
+
+			return found;
+		}
+
+		// bounces a particle off the plane until it catches up with its own time
+		static void resolveRebound(ReboundState& r, float t, float planeY)
+		{
+			// bounce at most this many times per update so a particle stuck on the plane can't stall the frame
+			const int maxBounces = 8;
+			const float restingSpeed = 0.001f;
+
+			for (int i = 0; i < maxBounces && !r.resting; ++i)
+			{
+				float hit;
+				if (!findPlaneCrossing(r.position.y - planeY, r.velocity.y, r.acceleration.y, t - r.time, hit))
+					break;
+
+				r.position += (r.velocity * hit) + (r.acceleration * (hit * hit));
+				r.velocity += r.acceleration * (2.0f * hit);
+				r.position.y = planeY;
+				r.velocity.y *= -r.coeff;
+				r.time += hit;
+				++r.count;
+
+				// too slow to leave the plane again. slide along it
+				if (fabsf(r.velocity.y) < restingSpeed)
+				{
+					r.velocity.y = 0.0f;
+					r.acceleration.y = 0.0f;
+					r.resting = true;
+				}
+			}
+		}
+
+		// tests four particles at once for whether they can touch the plane before catching up with their time.
+		// the lowest point of h + v*t + a*t^2 over the step is either its end or the vertex of the parabola,
+		// so most particles are rejected without solving for the crossing. the rest are resolved one by one.
+		static void resolveRebounds(ReboundState** states, const float* times, size_t count, float planeY)
+		{
+			using namespace DirectX;
+			const float tolerance = 0.0001f;
+
+			// unused lanes sit above the plane and don't move
+			XMFLOAT4 h{ 1.0f, 1.0f, 1.0f, 1.0f }, v{}, a{}, dt{};
+			for (size_t i = 0; i < count; ++i)
+			{
+				const ReboundState& r = *states[i];
+				(&h.x)[i] = r.position.y - planeY;
+				(&v.x)[i] = r.velocity.y;
+				(&a.x)[i] = r.acceleration.y;
+				(&dt.x)[i] = times[i] - r.time;
+			}
+
+			XMVECTOR H = XMLoadFloat4(&h);
+			XMVECTOR V = XMLoadFloat4(&v);
+			XMVECTOR A = XMLoadFloat4(&a);
+			XMVECTOR D = XMLoadFloat4(&dt);
+
+			XMVECTOR end = XMVectorMultiplyAdd(XMVectorMultiplyAdd(A, D, V), D, H);
+
+			// only an upward opening parabola has its lowest point inside the step
+			XMVECTOR opensUp = XMVectorGreater(A, XMVectorReplicate(0.00000001f));
+			XMVECTOR safeA = XMVectorSelect(g_XMOne, A, opensUp);
+			XMVECTOR vertexTime = XMVectorDivide(XMVectorNegate(V), XMVectorScale(safeA, 2.0f));
+			XMVECTOR inStep = XMVectorAndInt(opensUp, XMVectorAndInt(XMVectorGreater(vertexTime, XMVectorZero()), XMVectorLess(vertexTime, D)));
+			XMVECTOR vertex = XMVectorSubtract(H, XMVectorDivide(XMVectorMultiply(V, V), XMVectorScale(safeA, 4.0f)));
+			XMVECTOR lowest = XMVectorMin(end, XMVectorSelect(g_XMInfinity, vertex, inStep));
+
+			uint32_t touches[4];
+			XMStoreInt4(touches, XMVectorLessOrEqual(lowest, XMVectorReplicate(tolerance)));
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (touches[i])
+					resolveRebound(*states[i], times[i], planeY);
+			}
+		}
+
+		void ParticleInstance::updateRebounds(float time, const DirectX::XMMATRIX& emM4, const DirectX::XMMATRIX& emM4Origin)
+		{
+			auto& particle = reference->getParticle();
+			float planeY = particle->getReboundPlaneY();
+			bool emitterLocal = particle->getFlags() & 4;
+			Vector3 gravity = particle->getGravitationalAccel() / 3600;
+
+			ReboundState* batch[4];
+			float batchTimes[4];
+			size_t batchSize = 0;
+
+			for (auto& p : pool)
+			{
+				if (p.dead)
+					continue;
+
+				float t = time - p.startTime;
+				ReboundState& r = p.rebound;
+
+				// time went backwards, start over from the emission
+				if (r.count && t < r.time)
+				{
+					r.count = 0;
+					r.resting = false;
+				}
+
+				if (!r.count)
+				{
+					r.position = p.basePos;
+					r.velocity = p.direction;
+					r.acceleration = p.acceleration;
+					r.time = 0.0f;
+
+					if (emitterLocal)
+					{
+						r.position = MathExtensions::vector3Transform(r.position, emM4Origin);
+						r.position.x += emM4.r[3].m128_f32[0];
+						r.position.y += emM4.r[3].m128_f32[1];
+						r.position.z += emM4.r[3].m128_f32[2];
+						r.velocity = MathExtensions::vector3Transform(r.velocity, emM4Origin);
+						r.acceleration = MathExtensions::vector3Transform(r.acceleration, emM4Origin);
+					}
+
+					r.acceleration += gravity;
+				}
+
+				if (r.resting)
+					continue;
+
+				batch[batchSize] = &r;
+				batchTimes[batchSize] = t;
+				if (++batchSize == 4)
+				{
+					resolveRebounds(batch, batchTimes, batchSize, planeY);
+					batchSize = 0;
+				}
+			}
+
+			if (batchSize)
+				resolveRebounds(batch, batchTimes, batchSize, planeY);
+		}
+
+		void ParticleInstance::update(float time, const Camera& camera, const ParticleCulling& culling, const DirectX::XMMATRIX &emM4, const Quaternion &emRot)
 		{
 			verifyPoolSize();
 
+			// instances that were off-screen last frame only need their bounds unless they come back into view
+			bool boundsOnly = culled && culling.isFrustumCulling() && culling.isSimulationCulling();
+			simulate(time, camera, emM4, emRot, boundsOnly);
+
+			culled = aliveCount && !culling.isVisible(bounds);
+			if (boundsOnly && !culled)
+				simulate(time, camera, emM4, emRot, false);
+		}
+
+		void ParticleInstance::simulate(float time, const Camera& camera, const DirectX::XMMATRIX &emM4, const Quaternion &emRot, bool boundsOnly)
+		{
 			auto& particle = reference->getParticle();
 
 			// calculate UV params.
@@ -163,8 +545,7 @@ namespace Glitter
 			UVIndexType type = particle->getUVIndexType();
 			if (reference->getMaterialNode())
 			{
-				Vector2 uvSplit = reference->getMaterialNode()->getMaterial()->getSplit();
-				maxUV = ((int)uvSplit.x * (int)uvSplit.y) - 1;
+				maxUV = reference->getMaterialNode()->getUVFrameCount() - 1;
 			}
 
 			DirectX::XMMATRIX emM4Origin = emM4;
@@ -178,17 +559,36 @@ namespace Glitter
 
 			ParticleDirectionType dType = particle->getDirectionType();
 			std::shared_ptr<EditorAnimationSet> animationSet = reference->getAnimationSet();
+			bool rebuildAnimations = animationRevision != animationSet->getRevision();
+
+			// conservative bounds are grown by each particle's largest possible extent around its position.
+			// quads are at most one unit wide with the pivot on an edge, mesh particles use the model's bounding sphere.
+			float extentFactor = 1.5f;
+			if (particle->getType() == ParticleType::Mesh)
+				extentFactor = reference->getMesh() ? reference->getMesh()->getRadius() : 0.0f;
+
+			// bounces are resolved for the whole pool up front. particles that never hit the plane keep the closed form motion
+			bool rebound = particle->getReflectionCoeff() != 0.0f || particle->getReflectionCoeffRandom() != 0.0f;
+			if (rebound)
+				updateRebounds(time, emM4, emM4Origin);
+
+			DirectX::XMVECTOR boundsMin = DirectX::XMVectorReplicate(FLT_MAX);
+			DirectX::XMVECTOR boundsMax = DirectX::XMVectorReplicate(-FLT_MAX);
 
 			aliveCount = 0;
+			size_t died = 0;
 			for (auto& p : pool)
 			{
-				if (p.time > particle->getLifeTime() || p.time < 0.0f)
+				if (!p.dead && (p.time > particle->getLifeTime() || p.time < 0.0f))
+				{
 					p.dead = true;
+					++died;
+				}
 
 				if (p.dead)
 					continue;
 
-				if (animationSet->isDirty())
+				if (rebuildAnimations)
 					p.animation.buildCache(animationSet);
 
 				float lastTime = p.time;
@@ -214,6 +614,11 @@ namespace Glitter
 				Vector3 animT = MathExtensions::vector3Transform(p.animation.tryGetTranslation(p.time), emM4Origin);
 
 				Vector3 translation = basePos + (velocity * p.time) + animT + gravity;
+				if (rebound && p.rebound.count)
+				{
+					float t = p.time - p.rebound.time;
+					translation = p.rebound.position + (p.rebound.velocity * t) + (p.rebound.acceleration * (t * t)) + animT;
+				}
 				Vector3 rotation = p.rotation + p.animation.tryGetRotation(p.time);
 				Vector3 scaling = p.animation.tryGetScale(p.time);
 
@@ -227,6 +632,25 @@ namespace Glitter
 						scaling *= p.scale;
 				}
 
+				float extent = std::max(std::max(fabsf(scaling.x), fabsf(scaling.y)), fabsf(scaling.z)) * extentFactor;
+				DirectX::XMVECTOR extentV = DirectX::XMVectorReplicate(extent);
+				DirectX::XMVECTOR center{ translation.x, translation.y, translation.z, 1.0f };
+				boundsMin = DirectX::XMVectorMin(boundsMin, DirectX::XMVectorSubtract(center, extentV));
+				boundsMax = DirectX::XMVectorMax(boundsMax, DirectX::XMVectorAdd(center, extentV));
+
+				for (const LocusHistory& history : p.locusHistories)
+				{
+					DirectX::XMVECTOR historyPos{ history.pos.x, history.pos.y, history.pos.z, 1.0f };
+					boundsMin = DirectX::XMVectorMin(boundsMin, DirectX::XMVectorSubtract(historyPos, extentV));
+					boundsMax = DirectX::XMVectorMax(boundsMax, DirectX::XMVectorAdd(historyPos, extentV));
+				}
+
+				if (boundsOnly)
+				{
+					++aliveCount;
+					continue;
+				}
+
 				Vector3 pivot = getAnchorPoint(particle->getPivotPosition());
 				pivot *= scaling;
 
@@ -375,13 +799,21 @@ namespace Glitter
 
 				++aliveCount;
 			}
-			
-			// all animations should be up to date here.
-			animationSet->markDirty(false);
+
+			if (aliveCount)
+				DirectX::BoundingBox::CreateFromPoints(bounds, boundsMin, boundsMax);
+
+			ParticleBudget::release(died);
+
+			// all animations are up to date here. dead particles build theirs when they are created
+			animationRevision = animationSet->getRevision();
 		}
 
 		void ParticleInstance::create(int n, float startTime, EmissionDirectionType dir, const std::vector<Vector3>& basePos)
 		{
+			if (n <= 0 || basePos.size() < (size_t)n)
+				return;
+
 			int count = 0;
 			for (std::vector<ParticleStatus>::iterator it = pool.begin(); it != pool.end(); ++it)
 			{
@@ -392,6 +824,11 @@ namespace Glitter
 					p.startTime = startTime;
 					p.time = 0.0f;
 					p.dead = false;
+					p.childSpawned = false;
+					p.rebound = ReboundState();
+
+					if (particle->getReflectionCoeff() != 0.0f || particle->getReflectionCoeffRandom() != 0.0f)
+						p.rebound.coeff = Utilities::randomize(particle->getReflectionCoeff(), particle->getReflectionCoeffRandom());
 
 					float speed = Utilities::randomize(particle->getSpeed(), particle->getSpeedRandom());
 					float deceleration = Utilities::randomize(particle->getDeceleration(), particle->getDecelerationRandom());
@@ -437,11 +874,9 @@ namespace Glitter
 					// InitialRandom UVIndex Types
 					if ((size_t)particle->getUVIndexType() >= 1 && (size_t)particle->getUVIndexType() < 5)
 					{
-						Vector2 uvSplit = Vector2(1.0f, 1.0f);
+						unsigned int maxUV = 0;
 						if (reference->getMaterialNode())
-							uvSplit = reference->getMaterialNode()->getMaterial()->getSplit();
-
-						unsigned int maxUV = (uvSplit.x * uvSplit.y) - 1;
+							maxUV = reference->getMaterialNode()->getUVFrameCount() - 1;
 						p.UVIndex = Utilities::random(0, maxUV);
 					}
 
@@ -452,6 +887,10 @@ namespace Glitter
 				if (count >= n)
 					return;
 			}
+
+			// emission granted beyond the pool's capacity goes back to the budget
+			if (count < n)
+				ParticleBudget::release(n - count);
 		}
 	}
 }
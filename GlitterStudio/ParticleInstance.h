@@ -2,11 +2,19 @@
 #include "ParticleNode.h"
 #include "CachedAnimation.h"
 #include "Camera.h"
+#include "ParticleCulling.h"
+#include "ParticleBudget.h"
 
 namespace Glitter
 {
 	namespace Editor
 	{
+		class EmitterNode;
+
+		// child emitter instances are preallocated per parent instance. deeper levels get smaller pools.
+		constexpr int maxChildEmitterDepth = 3;
+		constexpr size_t maxChildEmitterInstances = 32;
+
 		struct LocusHistory
 		{
 			Vector3 pos;
@@ -14,6 +22,18 @@ namespace Glitter
 			Color color;
 		};
 
+		// motion after the last bounce off the rebound plane. each bounce restarts the closed form motion from the hit.
+		struct ReboundState
+		{
+			Vector3 position;
+			Vector3 velocity;
+			Vector3 acceleration;
+			float coeff = 0.0f;
+			float time = 0.0f;
+			int count = 0;
+			bool resting = false;
+		};
+
 		struct ParticleStatus
 		{
 			DirectX::XMMATRIX mat4;
@@ -29,14 +49,39 @@ namespace Glitter
 			float startTime;
 			float time;
 			bool dead;
+			bool childSpawned;
+			ReboundState rebound;
 			std::vector<LocusHistory> locusHistories;
 			CachedAnimation animation;
 
-			ParticleStatus() : dead{ true }
+			ParticleStatus() : dead{ true }, childSpawned{ false }
 			{
 			}
 		};
 
+		struct ChildEmitter
+		{
+			std::shared_ptr<EmitterNode> node;
+			DirectX::XMVECTOR origin;
+			size_t parentSlot = 0;
+			float parentStartTime = 0.0f;
+			float spawnTime = 0.0f;
+			bool active = false;
+		};
+
+		struct ChildEmitterPool
+		{
+			std::vector<ChildEmitter> instances;
+			size_t activeCount = 0;
+		};
+
+		// simulation state of a particle instance. animation caches are left out and rebuilt on restore.
+		struct ParticleInstanceState
+		{
+			std::vector<ParticleStatus> pool;
+			size_t rotationAddCount = 0;
+		};
+
 		class ParticleInstance
 		{
 		private:
@@ -44,19 +89,38 @@ namespace Glitter
 			std::vector<ParticleStatus> pool;
 			size_t rotationAddCount;
 			size_t aliveCount;
+			size_t animationRevision;
 			bool visible;
+			bool culled;
+			bool childrenPrepared;
+			DirectX::BoundingBox bounds;
+			std::vector<ChildEmitterPool> childPools;
 
 			void verifyPoolSize();
 			void updateLocusHistory(ParticleStatus& p);
+			void updateRebounds(float time, const DirectX::XMMATRIX& emM4, const DirectX::XMMATRIX& emM4Origin);
+			void simulate(float time, const Camera& camera, const DirectX::XMMATRIX& emM4, const Quaternion& emRot, bool boundsOnly);
 
 		public:
 			ParticleInstance(std::weak_ptr<ParticleNode> ref);
 
-			void update(float time, const Camera& camera, const DirectX::XMMATRIX& emM4, const Quaternion& emRot);
+			void update(float time, const Camera& camera, const ParticleCulling& culling, const DirectX::XMMATRIX& emM4, const Quaternion& emRot);
 			void create(int count, float startTime, EmissionDirectionType dir, const std::vector<Vector3>& pos);
+			void prepareChildEmitters(const std::vector<std::shared_ptr<EmitterNode>>& emitters, int depth);
+			void updateChildEmitters(float time, const Camera& camera, const ParticleCulling& culling, BudgetPriority priority, const Quaternion& emRot);
+			void killChildEmitters();
+			void clearChildEmitters();
+			bool isChildEmittersPrepared() const;
+			bool hasActiveChildEmitters() const;
+			std::vector<ChildEmitterPool>& getChildEmitters();
 			void kill();
+			ParticleInstanceState saveState() const;
+			void restoreState(const ParticleInstanceState& state);
 			void setVisible(bool val);
 			bool isVisible() const;
+			bool isCulled() const;
+			void setCulled(bool val);
+			const DirectX::BoundingBox& getBounds() const;
 			Vector3 getAnchorPoint(PivotPosition pivot);
 
 			std::vector<ParticleStatus>& getPool();
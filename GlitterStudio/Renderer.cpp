@@ -4,9 +4,41 @@
 #include "Utilities.h"
 #include "ResourceManager.h"
 #include "..\DirectXMath-master\Inc\DirectXMath.h"
+#include <chrono>
+#include <algorithm>
+
+// blend modes whose draws can be reordered among themselves without changing the result.
+// opaque draws rely on the depth test, additive and multiplicative blending are commutative
+static int getBlendOrderClass(Glitter::BlendMode mode)
+{
+	switch (mode)
+	{
+	case Glitter::BlendMode::Zero:
+	case Glitter::BlendMode::Opaque:
+		return 1;
+
+	case Glitter::BlendMode::Add:
+		return 2;
+
+	case Glitter::BlendMode::Multiply:
+		return 3;
+
+	default:
+		return 0;
+	}
+}
+
+ShaderBinding::ShaderBinding(std::shared_ptr<Shader> s) :
+	shader{ s }
+{
+	blendMode		= shader->getUniform<int>("blendMode");
+	instanced		= shader->getUniform<bool>("instanced");
+	layered			= shader->getUniform<bool>("layered");
+	diffuseArray	= shader->getUniform<int>("diffuseArray");
+}
 
 Renderer::Renderer() :
-	numVertices{ 0 }, numIndices{ 0 }, numQuads{ 0 }, texID{ -1 }, batchStarted{ false }
+	numVertices{ 0 }, numIndices{ 0 }, numQuads{ 0 }, numCulled{ 0 }, numDrawCalls{ 0 }, drawLayer{ 0 }, lastOrderClass{ -1 }, uploadSize{ 0 }, fillTime{ 0.0 }, texID{ -1 }, batchSampler{ 0 }, batchStarted{ false }, instancing{ true }, batchLayered{ false }, sorting{ true }, depthSorting{ true }, depthAxis{ 0.0f, 0.0f, 1.0f, 0.0f }, uvFrames{ nullptr }, shader{ nullptr }
 {
 	size_t offset = 0;
 	for (size_t index = 0; index < maxIndices; index += 6)
@@ -24,12 +56,23 @@ Renderer::Renderer() :
 
 	initGrid();
 	initQuad();
+	initInstancedQuad();
+	initSamplers();
+	glGenBuffers(1, &mVbo);
+
+	glGenBuffers(1, &frameUbo);
+	glBindBuffer(GL_UNIFORM_BUFFER, frameUbo);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), NULL, GL_DYNAMIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, frameDataBinding, frameUbo);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
 	bufferBase = buffer;
+	instanceCurrent = instances;
 
-	billboardShader		= ResourceManager::getShader("BillboardParticle");
-	meshParticleShader	= ResourceManager::getShader("MeshParticle");
-	gridShader			= ResourceManager::getShader("Grid");
-	meshShader			= ResourceManager::getShader("Mesh");
+	billboardShader		= ShaderBinding(ResourceManager::getShader("BillboardParticle"));
+	meshParticleShader	= ShaderBinding(ResourceManager::getShader("MeshParticle"));
+	gridShader			= ShaderBinding(ResourceManager::getShader("Grid"));
+	meshShader			= ShaderBinding(ResourceManager::getShader("Mesh"));
 
 	// set different blending modes here so that setBlendMode does not return early
 	blendMode = Glitter::BlendMode::Zero;
@@ -42,14 +85,43 @@ Renderer::~Renderer()
 	glDeleteBuffers(1, &ebo);
 	glDeleteVertexArrays(1, &vao);
 
+	glDeleteBuffers(1, &qVbo);
+	glDeleteBuffers(1, &iVbo);
+	glDeleteVertexArrays(1, &iVao);
+	glDeleteBuffers(1, &mVbo);
+	glDeleteBuffers(1, &frameUbo);
+
 	glDeleteBuffers(1, &gVbo);
 	glDeleteVertexArrays(1, &gVao);
+
+	glDeleteSamplers(samplers.size(), samplers.data());
+}
+
+void Renderer::initSamplers()
+{
+	// one sampler per material address mode. packed textures share a page, so the
+	// material's sampling state can't live on the texture itself
+	glGenSamplers(samplers.size(), samplers.data());
+	for (size_t i = 0; i < samplers.size(); ++i)
+	{
+		GLint wrap = (Glitter::AddressMode)i == Glitter::AddressMode::Clamp ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+		glSamplerParameteri(samplers[i], GL_TEXTURE_WRAP_S, wrap);
+		glSamplerParameteri(samplers[i], GL_TEXTURE_WRAP_T, wrap);
+		glSamplerParameteri(samplers[i], GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glSamplerParameteri(samplers[i], GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	}
+}
+
+unsigned int Renderer::getSampler(Glitter::AddressMode mode) const
+{
+	size_t index = (size_t)mode;
+	return index < samplers.size() ? samplers[index] : samplers[(size_t)Glitter::AddressMode::Wrap];
 }
 
-void Renderer::bindShader(std::shared_ptr<Shader>& s)
+void Renderer::bindShader(ShaderBinding& s)
 {
-	shader = s;
-	shader->use();
+	shader = &s;
+	shader->shader->use();
 }
 
 void Renderer::resetVPos()
@@ -76,38 +148,102 @@ void Renderer::initQuad()
 	glGenBuffers(1, &ebo);
 
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, maxVertices * sizeof(VertexBuffer), NULL, GL_DYNAMIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, maxVertices * sizeof(ParticleVertex), NULL, GL_DYNAMIC_DRAW);
 
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
 
 	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexBuffer), (void*)offsetof(VertexBuffer, position));
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ParticleVertex), (void*)offsetof(ParticleVertex, position));
 
 	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(VertexBuffer), (void*)offsetof(VertexBuffer, color));
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ParticleVertex), (void*)offsetof(ParticleVertex, color));
 
 	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(VertexBuffer), (void*)offsetof(VertexBuffer, uv));
+	glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(ParticleVertex), (void*)offsetof(ParticleVertex, uv));
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
 }
 
-void Renderer::configureShader(std::shared_ptr<Shader>& s, const Glitter::Editor::Viewport &vp, Glitter::BlendMode blend)
+void Renderer::initInstancedQuad()
 {
-	if (shader != s)
-		bindShader(s);
+	glGenVertexArrays(1, &iVao);
+	glBindVertexArray(iVao);
+
+	DirectX::XMFLOAT3 quad[4];
+	for (size_t i = 0; i < 4; ++i)
+		DirectX::XMStoreFloat3(&quad[i], vPos[i]);
+
+	glGenBuffers(1, &qVbo);
+	glBindBuffer(GL_ARRAY_BUFFER, qVbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(DirectX::XMFLOAT3), (void*)0);
+
+	// the first six indices of the batch index buffer describe a single quad
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+
+	glGenBuffers(1, &iVbo);
+	glBindBuffer(GL_ARRAY_BUFFER, iVbo);
+	glBufferData(GL_ARRAY_BUFFER, maxQuads * sizeof(QuadInstance), NULL, GL_DYNAMIC_DRAW);
+
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(QuadInstance), (void*)offsetof(QuadInstance, center));
+	glVertexAttribDivisor(3, 1);
+
+	glEnableVertexAttribArray(4);
+	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(QuadInstance), (void*)offsetof(QuadInstance, axisX));
+	glVertexAttribDivisor(4, 1);
+
+	glEnableVertexAttribArray(5);
+	glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, sizeof(QuadInstance), (void*)offsetof(QuadInstance, axisY));
+	glVertexAttribDivisor(5, 1);
+
+	glEnableVertexAttribArray(6);
+	glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(QuadInstance), (void*)offsetof(QuadInstance, color));
+	glVertexAttribDivisor(6, 1);
 
+	glEnableVertexAttribArray(7);
+	glVertexAttribPointer(7, 4, GL_HALF_FLOAT, GL_FALSE, sizeof(QuadInstance), (void*)offsetof(QuadInstance, uvMin));
+	glVertexAttribDivisor(7, 1);
+
+	glEnableVertexAttribArray(8);
+	glVertexAttribPointer(8, 1, GL_FLOAT, GL_FALSE, sizeof(QuadInstance), (void*)offsetof(QuadInstance, layer));
+	glVertexAttribDivisor(8, 1);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+void Renderer::beginFrame(const Glitter::Editor::Viewport &vp)
+{
 	Camera cam = vp.getCamera();
 	Glitter::Vector2 size = vp.getSize();
 
-	shader->setMatrix4("view", cam.getViewMatrix());
-	shader->setMatrix4("projection", cam.getProjectionMatrix(size.x / size.y));
-	if (shader->getName() != "Grid")
-	{
-		shader->setInt("blendMode", (int)blend);
-	}
+	FrameData frame;
+	frame.view = cam.getViewMatrix();
+	frame.projection = cam.getProjectionMatrix(size.x / size.y);
+	frame.cameraPosition = DirectX::XMVectorSetW(cam.getPosition(), 1.0f);
+
+	// third column of the view matrix gives view space depth
+	const DirectX::XMMATRIX& view = frame.view;
+	depthAxis = DirectX::XMVECTOR{ view.r[0].m128_f32[2], view.r[1].m128_f32[2], view.r[2].m128_f32[2], view.r[3].m128_f32[2] };
+	frame.viewDirection = DirectX::XMVector3Normalize(DirectX::XMVECTOR{ -depthAxis.m128_f32[0], -depthAxis.m128_f32[1], -depthAxis.m128_f32[2], 0.0f });
+
+	glBindBuffer(GL_UNIFORM_BUFFER, frameUbo);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &frame);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void Renderer::configureShader(ShaderBinding& s, Glitter::BlendMode blend)
+{
+	if (shader != &s)
+		bindShader(s);
+
+	// shaders without the uniform resolve to -1, which GL ignores
+	shader->shader->set(shader->blendMode, (int)blend);
 }
 
 void Renderer::setBlendMode(Glitter::BlendMode mode)
@@ -161,89 +297,170 @@ void Renderer::setBlendMode(Glitter::BlendMode mode)
 void Renderer::beginBatch()
 {
 	bufferCurrent	= bufferBase;
+	instanceCurrent	= instances;
 	numVertices		= 0;
 	numIndices		= 0;
 	numQuads		= 0;
 	batchStarted	= true;
 }
 
+float Renderer::getViewDepth(const DirectX::XMFLOAT3& position) const
+{
+	DirectX::XMVECTOR p{ position.x, position.y, position.z, 1.0f };
+	return DirectX::XMVectorGetX(DirectX::XMVector4Dot(p, depthAxis));
+}
+
 void Renderer::endBatch()
 {
-	size_t size = (uint8_t*)bufferCurrent - (uint8_t*)bufferBase;
-	glBindVertexArray(vao);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferSubData(GL_ARRAY_BUFFER, 0, size, buffer);
+	// blending that depends on draw order gets its quads drawn back to front
+	bool sortBatch = depthSorting && numQuads > 1 && getBlendOrderClass(blendMode) == 0;
+
+	if (instancing)
+	{
+		const QuadInstance* data = instances;
+		if (sortBatch)
+		{
+			sortDepths.resize(numQuads);
+			for (size_t i = 0; i < numQuads; ++i)
+				sortDepths[i] = getViewDepth(instances[i].center);
+
+			// view space looks down -z, so the most negative depth is the farthest
+			const std::vector<uint32_t>& order = depthSorter.sort(sortDepths);
+			sortedInstances.resize(numQuads);
+			for (size_t i = 0; i < numQuads; ++i)
+				sortedInstances[i] = instances[order[i]];
+
+			data = sortedInstances.data();
+		}
+
+		size_t size = (uint8_t*)instanceCurrent - (uint8_t*)instances;
+		glBindVertexArray(iVao);
+		glBindBuffer(GL_ARRAY_BUFFER, iVbo);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+		uploadSize += size;
+	}
+	else
+	{
+		const ParticleVertex* data = buffer;
+		if (sortBatch)
+		{
+			// opposite corners of a quad average to its center
+			sortDepths.resize(numQuads);
+			for (size_t i = 0; i < numQuads; ++i)
+				sortDepths[i] = (getViewDepth(buffer[i * 4].position) + getViewDepth(buffer[i * 4 + 2].position)) * 0.5f;
+
+			const std::vector<uint32_t>& order = depthSorter.sort(sortDepths);
+			sortedVertices.resize(numQuads * 4);
+			for (size_t i = 0; i < numQuads; ++i)
+				std::copy_n(&buffer[order[i] * 4], 4, &sortedVertices[i * 4]);
+
+			data = sortedVertices.data();
+		}
+
+		size_t size = (uint8_t*)bufferCurrent - (uint8_t*)bufferBase;
+		glBindVertexArray(vao);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+		uploadSize += size;
+	}
 	
 	flush();
+
+	// mesh draws sample with their textures' own state
+	glBindSampler(batchLayered ? 1 : 0, 0);
 	texID = -1;
+	batchSampler = 0;
 	batchStarted = false;
 }
 
 void Renderer::flush()
 {
-	glDrawElements(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, 0);
+	if (numQuads)
+		++numDrawCalls;
+
+	shader->shader->set(shader->instanced, instancing);
+	shader->shader->set(shader->layered, batchLayered);
+	shader->shader->set(shader->diffuseArray, 1);
+	if (instancing)
+		glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, numQuads);
+	else
+		glDrawElements(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, 0);
+}
+
+void Renderer::setInstancing(bool enabled)
+{
+	if (batchStarted)
+		endBatch();
+
+	instancing = enabled;
 }
 
-void Renderer::getUVCoords(std::shared_ptr<Glitter::Editor::MaterialNode> mat)
+const Glitter::Editor::UVFrame& Renderer::getUVFrame(unsigned int index) const
 {
-	auto tex = mat->getTexture();
+	if (index >= uvFrames->size())
+		index = uvFrames->size() - 1;
 
-	Glitter::Vector2 split = mat->getMaterial()->getSplit();
-	size_t maxUV = (split.x * split.y) - 1;
+	return (*uvFrames)[index];
+}
 
-	uvCoords.clear();
-	uvCoords.reserve(maxUV + 1);
-	for (size_t index = 0; index <= maxUV; ++index)
-	{
-		float x = index % (int)split.x;
-		float y = index / (int)split.y;
-		float w = tex->getWidth() / (int)split.x;
-		float h = tex->getHeight() / (int)split.y;
-
-		float left = (x * w) / tex->getWidth();
-		float right = ((x * w) + w) / tex->getWidth();
-		float top = (y * h) / tex->getHeight();
-		float bottom = ((y * h) + h) / tex->getHeight();
-
-		std::array<DirectX::XMVECTOR, 4> arr;
-		arr[0] = DirectX::XMVECTOR{ left, top };
-		arr[1] = DirectX::XMVECTOR{ left, bottom };
-		arr[2] = DirectX::XMVECTOR{ right, bottom };
-		arr[3] = DirectX::XMVECTOR{ right, top };
-		uvCoords.emplace_back(arr);
-	}
+unsigned int Renderer::getBatchTexture(const TextureData& tex) const
+{
+	// only instanced quads carry a layer index
+	if (instancing && tex.getArrayLayer() >= 0)
+		return tex.getArrayID();
+
+	return tex.getID();
 }
 
 void Renderer::drawPoolMesh(Glitter::Editor::ParticleInstance &instance, const Camera &camera)
 {
-	std::vector<Glitter::Editor::ParticleStatus> pool = instance.getPool();
-	
+	const std::vector<Glitter::Editor::ParticleStatus>& pool = instance.getPool();
+
+	meshInstances.clear();
 	for (auto& p : pool)
 	{
 		if (!p.dead)
 		{
-			DirectX::XMMATRIX model = p.mat4;
-
-			meshParticleShader->setMatrix4("model", model);
-			meshParticleShader->setVec4("color", DirectX::XMVECTOR{ p.color.r, p.color.g, p.color.b, p.color.a });
-			meshParticleShader->setVec2("uvOffset", DirectX::XMVECTOR{ p.uvScroll.x, p.uvScroll.y });
-			instance.getReference()->getMesh()->draw(meshParticleShader.get(), 0);
+			InstanceData data;
+			DirectX::XMStoreFloat4x4(&data.model, p.mat4);
+			DirectX::PackedVector::XMStoreUByteN4(&data.color, DirectX::XMVECTOR{ p.color.r, p.color.g, p.color.b, p.color.a });
+			data.uvOffset = DirectX::XMFLOAT2{ p.uvScroll.x, p.uvScroll.y };
+			meshInstances.emplace_back(data);
 		}
 	}
+
+	if (meshInstances.empty())
+		return;
+
+	// orphan the previous contents so the driver doesn't wait on draws still using them
+	size_t size = meshInstances.size() * sizeof(InstanceData);
+	glBindBuffer(GL_ARRAY_BUFFER, mVbo);
+	glBufferData(GL_ARRAY_BUFFER, size, meshInstances.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	uploadSize += size;
+
+	instance.getReference()->getMesh()->drawInstanced(meshParticleShader.shader.get(), 0, mVbo, meshInstances.size());
+	++numDrawCalls;
 }
 
 void Renderer::drawPoolQuad(Glitter::Editor::ParticleInstance& instance, const Camera &camera)
 {
+	auto fillStart = std::chrono::high_resolution_clock::now();
+
 	std::shared_ptr<Glitter::Editor::MaterialNode> mat = instance.getReference()->getMaterialNode();
 	std::vector<Glitter::Editor::ParticleStatus> &pool = instance.getPool();
+	unsigned int sampler = getSampler(mat->getMaterial()->getAddressMode());
+
+	uvFrames = &mat->getUVFrames().frames;
+	if (uvFrames->empty())
+		return;
 
-	getUVCoords(mat);
 	if (instance.getParticle()->getType() == Glitter::ParticleType::Quad)
 	{
 		for (auto& p : pool)
 		{
 			if (!p.dead)
-				drawQuad(p.mat4, p.color, p.UVIndex, p.uvScroll, mat->getTexture());
+				drawQuad(p.mat4, p.color, p.UVIndex, p.uvScroll, mat->getTexture(), sampler);
 		}
 	}
 	else if (instance.getParticle()->getType() == Glitter::ParticleType::Locus)
@@ -251,15 +468,19 @@ void Renderer::drawPoolQuad(Glitter::Editor::ParticleInstance& instance, const C
 		for (auto& p : pool)
 		{
 			//if (!p.dead)
-				drawLocus(p, mat->getTexture());
+				drawLocus(p, mat->getTexture(), sampler);
 		}
 	}
+
+	// includes the uploads of any batches flushed along the way
+	fillTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - fillStart).count();
 }
 
 void Renderer::drawQuad(const DirectX::XMMATRIX& m4, const Glitter::Color& color, unsigned int uvIndex,
-	const Glitter::Vector2 &uvS, std::shared_ptr<TextureData> tex)
+	const Glitter::Vector2 &uvS, std::shared_ptr<TextureData> tex, unsigned int sampler)
 {
-	if (numVertices >= maxVertices || texID != tex->getID())
+	unsigned int batchTex = getBatchTexture(*tex);
+	if (numVertices >= maxVertices || texID != batchTex || batchSampler != sampler)
 	{
 		endBatch();
 		beginBatch();
@@ -267,27 +488,74 @@ void Renderer::drawQuad(const DirectX::XMMATRIX& m4, const Glitter::Color& color
 
 	if (texID == -1)
 	{
-		texID = tex->getID();
-		glActiveTexture(GL_TEXTURE0);
-		tex->use();
+		texID = batchTex;
+		batchSampler = sampler;
+		batchLayered = batchTex != tex->getID();
+		if (batchLayered)
+		{
+			glActiveTexture(GL_TEXTURE1);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, batchTex);
+		}
+		else
+		{
+			glActiveTexture(GL_TEXTURE0);
+			tex->use();
+		}
+
+		glBindSampler(batchLayered ? 1 : 0, sampler);
 	}
 
-	if (uvIndex >= uvCoords.size())
-		uvIndex = uvCoords.size() - 1;
+	const Glitter::Editor::UVFrame& frame = getUVFrame(uvIndex);
 
 	DirectX::XMMATRIX model = m4;
-	DirectX::XMVECTOR colorV{ color.r, color.g, color.b, color.a };
+	DirectX::PackedVector::XMUBYTEN4 colorP;
+	DirectX::PackedVector::XMStoreUByteN4(&colorP, DirectX::XMVECTOR{ color.r, color.g, color.b, color.a });
 
-	float ufactor = uvCoords[uvIndex][3].m128_f32[0] - uvCoords[uvIndex][0].m128_f32[0];
-	float vFactor = uvCoords[uvIndex][1].m128_f32[1] - uvCoords[uvIndex][0].m128_f32[1];
+	float ufactor = frame.right - frame.left;
+	float vFactor = frame.bottom - frame.top;
 	DirectX::XMVECTOR uvAdd{ ufactor * uvS.x, vFactor * uvS.y };
+
+	// keep scrolled UVs close to zero so they don't lose precision as halfs.
+	// wrapping by an even amount gives the same result for repeat and mirror
+	DirectX::XMVECTOR two = DirectX::XMVectorReplicate(2.0f);
+	uvAdd = DirectX::XMVectorSubtract(uvAdd, DirectX::XMVectorMultiply(DirectX::XMVectorFloor(DirectX::XMVectorDivide(uvAdd, two)), two));
+
+	if (instancing)
+	{
+		// unit quad corners have z = 0, so the third row of the matrix never contributes
+		DirectX::XMStoreFloat3(&instanceCurrent->center, model.r[3]);
+		DirectX::XMStoreFloat3(&instanceCurrent->axisX, model.r[0]);
+		DirectX::XMStoreFloat3(&instanceCurrent->axisY, model.r[1]);
+		instanceCurrent->color = colorP;
+
+		DirectX::XMVECTOR uvRect{ frame.left, frame.top, frame.right, frame.bottom };
+		uvRect = DirectX::XMVectorAdd(uvRect, DirectX::XMVectorSwizzle<0, 1, 0, 1>(uvAdd));
+		DirectX::PackedVector::XMStoreHalf2(&instanceCurrent->uvMin, uvRect);
+		DirectX::PackedVector::XMStoreHalf2(&instanceCurrent->uvMax, DirectX::XMVectorSwizzle<2, 3, 0, 1>(uvRect));
+		instanceCurrent->layer = tex->getArrayLayer();
+		instanceCurrent++;
+
+		numVertices += 4;
+		numIndices += 6;
+		++numQuads;
+		return;
+	}
+
+	// same corner order as vPos
+	DirectX::XMVECTOR uvCorners[4]{
+		DirectX::XMVECTOR{ frame.left, frame.top },
+		DirectX::XMVECTOR{ frame.left, frame.bottom },
+		DirectX::XMVECTOR{ frame.right, frame.bottom },
+		DirectX::XMVECTOR{ frame.right, frame.top }
+	};
+
 	for (size_t i = 0; i < 4; ++i)
 	{
-		bufferCurrent->position = DirectX::XMVector3Transform(vPos[i], model);
-		bufferCurrent->color = colorV;
+		DirectX::XMStoreFloat3(&bufferCurrent->position, DirectX::XMVector3Transform(vPos[i], model));
+		bufferCurrent->color = colorP;
 
-		DirectX::XMVECTOR uvResult = DirectX::XMVectorAdd(uvCoords[uvIndex][i], uvAdd);
-		bufferCurrent->uv = uvResult;
+		DirectX::XMVECTOR uvResult = DirectX::XMVectorAdd(uvCorners[i], uvAdd);
+		DirectX::PackedVector::XMStoreHalf2(&bufferCurrent->uv, uvResult);
 		bufferCurrent++;
 	}
 
@@ -296,7 +564,7 @@ void Renderer::drawQuad(const DirectX::XMMATRIX& m4, const Glitter::Color& color
 	++numQuads;
 }
 
-void Renderer::drawLocus(const Glitter::Editor::ParticleStatus& p, std::shared_ptr<TextureData> tex)
+void Renderer::drawLocus(const Glitter::Editor::ParticleStatus& p, std::shared_ptr<TextureData> tex, unsigned int sampler)
 {
 	if (batchStarted)
 		endBatch();
@@ -304,16 +572,16 @@ void Renderer::drawLocus(const Glitter::Editor::ParticleStatus& p, std::shared_p
 	bufferCurrent = bufferBase;
 
 	texID = tex->getID();
+	batchLayered = false;
 	glActiveTexture(GL_TEXTURE0);
 	tex->use();
+	glBindSampler(0, sampler);
 
-	int uvIndex = p.UVIndex;
-	if (uvIndex >= uvCoords.size())
-		uvIndex = uvCoords.size() - 1;
-
-	float stepUVY = (uvCoords[uvIndex][1].m128_f32[1] - uvCoords[uvIndex][0].m128_f32[1]) / (float)p.locusHistories.size();
+	const Glitter::Editor::UVFrame& frame = getUVFrame(std::max(p.UVIndex, 0));
+	float stepUVY = (frame.bottom - frame.top) / (float)p.locusHistories.size();
 
-	DirectX::XMVECTOR color{ p.color.r, p.color.g, p.color.b, p.color.a };
+	DirectX::PackedVector::XMUBYTEN4 color;
+	DirectX::PackedVector::XMStoreUByteN4(&color, DirectX::XMVECTOR{ p.color.r, p.color.g, p.color.b, p.color.a });
 
 	for (int i = 0; i < p.locusHistories.size(); ++i)
 	{
@@ -328,79 +596,155 @@ void Renderer::drawLocus(const Glitter::Editor::ParticleStatus& p, std::shared_p
 		rightV = DirectX::XMVectorAdd(rightV, transformPos);
 		rightV = DirectX::XMVector3Transform(rightV, p.mat4);
 
-		float uvY = 1 - (uvCoords[uvIndex][1].m128_f32[1] - (stepUVY * i));
-		bufferCurrent->position = leftV;
+		float uvY = 1 - (frame.bottom - (stepUVY * i));
+		DirectX::XMStoreFloat3(&bufferCurrent->position, leftV);
 		bufferCurrent->color = color;
-		bufferCurrent->uv = DirectX::XMVECTOR{ uvCoords[uvIndex][0].m128_f32[0], uvY };
+		DirectX::PackedVector::XMStoreHalf2(&bufferCurrent->uv, DirectX::XMVECTOR{ frame.left, uvY });
 		bufferCurrent++;
 
-		bufferCurrent->position = rightV;
+		DirectX::XMStoreFloat3(&bufferCurrent->position, rightV);
 		bufferCurrent->color = color;
-		bufferCurrent->uv = DirectX::XMVECTOR{ uvCoords[uvIndex][2].m128_f32[0], uvY };
+		DirectX::PackedVector::XMStoreHalf2(&bufferCurrent->uv, DirectX::XMVECTOR{ frame.right, uvY });
 		bufferCurrent++;
 	}
 
 	size_t count = bufferCurrent - bufferBase;
+	shader->shader->set(shader->instanced, false);
+	shader->shader->set(shader->layered, false);
 	glBindVertexArray(vao);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(VertexBuffer), buffer);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(ParticleVertex), buffer);
+	uploadSize += count * sizeof(ParticleVertex);
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, count);
+	glBindSampler(0, 0);
+	++numDrawCalls;
 
 	bufferCurrent = bufferBase;
 }
 
+// layer | blend mode | address mode | shader | texture
+static uint64_t makeSortKey(uint32_t layer, Glitter::BlendMode mode, Glitter::AddressMode address, bool mesh, unsigned int texture)
+{
+	return ((uint64_t)(layer & 0xFFFFFF) << 40) | ((uint64_t)mode << 36) | ((uint64_t)address << 33) | ((uint64_t)mesh << 32) | texture;
+}
+
 void Renderer::drawEffect(Glitter::Editor::EffectNode* effNode, const Glitter::Editor::Viewport &vp)
 {
+	numCulled = 0;
+	numDrawCalls = 0;
+	uploadSize = 0;
+	fillTime = 0.0;
+
+	depthSorter.beginFrame();
+	drawList.clear();
+	drawLayer = 0;
+	lastOrderClass = -1;
+
 	for (auto& em : effNode->getEmitterNodes())
 	{
 		if (em->isVisible())
-		for (auto& instance : em->getParticles())
+			collectEmitter(em.get());
+	}
+
+	submitDrawList(vp.getCamera());
+
+	if (batchStarted)
+		endBatch();
+}
+
+void Renderer::collectEmitter(Glitter::Editor::EmitterNode* em)
+{
+	for (auto& instance : em->getParticles())
+	{
+		if (!instance.isVisible())
+			continue;
+
+		// child emitters have their own bounds, so draw them even if the parent is off-screen
+		for (auto& childPool : instance.getChildEmitters())
 		{
-			if (!instance.isVisible())
+			if (!childPool.activeCount)
 				continue;
 
-			std::shared_ptr<Glitter::Editor::ParticleNode> node = instance.getReference();
-			
-			// particles must have a material bound to render
-			if (node->getMaterialNode())
+			for (auto& child : childPool.instances)
 			{
-				Glitter::BlendMode mode = node->getParticle()->getBlendMode();
-
-				// switch to material's blend mode if the particle's is not set
-				if (mode == Glitter::BlendMode::Zero)
-					mode = node->getMaterialNode()->getMaterial()->getBlendMode();
-
-				setBlendMode(mode);
-				Glitter::ParticleDirectionType dir = instance.getParticle()->getDirectionType();
-
-				if (node->getParticle()->getType() == Glitter::ParticleType::Mesh)
-				{
-					if (node->getMesh())
-					{
-						if (batchStarted)
-							endBatch();
-
-						configureShader(meshParticleShader, vp, mode);
-						drawPoolMesh(instance, vp.getCamera());
-					}
-				}
-				else
-				{
-					if (node->getMaterialNode()->getTexture())
-					{
-						if (!batchStarted)
-							beginBatch();
-
-						configureShader(billboardShader, vp, mode);
-						drawPoolQuad(instance, vp.getCamera());
-					}
-				}
+				if (child.active)
+					collectEmitter(child.node.get());
 			}
 		}
+
+		// off-screen instances don't generate any vertices
+		if (em->isCulled() || instance.isCulled())
+		{
+			if (instance.getAliveCount())
+				++numCulled;
+
+			continue;
+		}
+
+		std::shared_ptr<Glitter::Editor::ParticleNode> node = instance.getReference();
+		
+		// particles must have a material bound to render
+		if (!node->getMaterialNode())
+			continue;
+
+		Glitter::BlendMode mode = node->getParticle()->getBlendMode();
+
+		// switch to material's blend mode if the particle's is not set
+		if (mode == Glitter::BlendMode::Zero)
+			mode = node->getMaterialNode()->getMaterial()->getBlendMode();
+
+		bool mesh = node->getParticle()->getType() == Glitter::ParticleType::Mesh;
+		Glitter::AddressMode address = node->getMaterialNode()->getMaterial()->getAddressMode();
+		unsigned int texture = 0;
+		if (mesh)
+		{
+			if (!node->getMesh())
+				continue;
+		}
+		else
+		{
+			if (!node->getMaterialNode()->getTexture())
+				continue;
+
+			texture = getBatchTexture(*node->getMaterialNode()->getTexture());
+		}
+
+		// draws may only move within a run of the same reorderable blend mode.
+		// anything else keeps its place in tree order
+		int orderClass = getBlendOrderClass(mode);
+		if (!sorting || orderClass == 0 || orderClass != lastOrderClass)
+			++drawLayer;
+
+		lastOrderClass = orderClass;
+		drawList.emplace_back(DrawItem{ makeSortKey(drawLayer, mode, address, mesh, texture), &instance, mode, mesh });
 	}
+}
 
-	if (batchStarted)
-		endBatch();
+void Renderer::submitDrawList(const Camera &camera)
+{
+	std::stable_sort(drawList.begin(), drawList.end(), [](const DrawItem& a, const DrawItem& b) { return a.key < b.key; });
+
+	for (const DrawItem& item : drawList)
+	{
+		setBlendMode(item.blendMode);
+
+		if (item.mesh)
+		{
+			if (batchStarted)
+				endBatch();
+
+			configureShader(meshParticleShader, item.blendMode);
+			drawPoolMesh(*item.instance, camera);
+		}
+		else
+		{
+			if (!batchStarted)
+				beginBatch();
+
+			configureShader(billboardShader, item.blendMode);
+			drawPoolQuad(*item.instance, camera);
+		}
+	}
 }
 
 void Renderer::initGrid()
@@ -472,7 +816,7 @@ void Renderer::initGrid()
 
 void Renderer::drawGrid(const Glitter::Editor::Viewport &vp)
 {
-	configureShader(gridShader, vp, Glitter::BlendMode::Typical);
+	configureShader(gridShader, Glitter::BlendMode::Typical);
 	setBlendMode(Glitter::BlendMode::Typical);
 
 	glBindVertexArray(gVao);
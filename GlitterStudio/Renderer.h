@@ -1,7 +1,9 @@
 #pragma once
 #include "EffectNode.h"
 #include "Viewport.h"
+#include "DepthSorter.h"
 #include "..\Dependencies\DirectXMath-master\Inc\DirectXMath.h"
+#include "..\Dependencies\DirectXMath-master\Inc\DirectXPackedVector.h"
 #include <array>
 
 constexpr size_t maxVertices	= 10000;
@@ -19,57 +21,152 @@ struct VertexBuffer
 	DirectX::XMVECTOR uv;
 };
 
+// packed vertex used by the particle batch. normalized RGBA8 color and half precision UVs
+struct ParticleVertex
+{
+	DirectX::XMFLOAT3 position;
+	DirectX::PackedVector::XMUBYTEN4 color;
+	DirectX::PackedVector::XMHALF2 uv;
+};
+
+static_assert(sizeof(ParticleVertex) == 20, "ParticleVertex must stay tightly packed");
+
+// per particle data for instanced quads. the unit quad is expanded in the vertex shader
+struct QuadInstance
+{
+	DirectX::XMFLOAT3 center;
+	DirectX::XMFLOAT3 axisX;
+	DirectX::XMFLOAT3 axisY;
+	DirectX::PackedVector::XMUBYTEN4 color;
+	// read as a single vec4 (left, top, right, bottom). split up to keep the struct 4 byte aligned
+	DirectX::PackedVector::XMHALF2 uvMin;
+	DirectX::PackedVector::XMHALF2 uvMax;
+	float layer;
+};
+
+static_assert(sizeof(QuadInstance) == 52, "QuadInstance must stay tightly packed");
+
+// std140 layout of the FrameData uniform block
+struct FrameData
+{
+	DirectX::XMMATRIX view;
+	DirectX::XMMATRIX projection;
+	DirectX::XMVECTOR cameraPosition;
+	DirectX::XMVECTOR viewDirection;
+};
+
+// a shader along with the handles of the uniforms the renderer sets on it
+struct ShaderBinding
+{
+	std::shared_ptr<Shader> shader;
+	Uniform<int> blendMode;
+	Uniform<bool> instanced;
+	Uniform<bool> layered;
+	Uniform<int> diffuseArray;
+
+	ShaderBinding() = default;
+	ShaderBinding(std::shared_ptr<Shader> s);
+};
+
 class Renderer
 {
 private:
+	struct DrawItem
+	{
+		uint64_t key;
+		Glitter::Editor::ParticleInstance* instance;
+		Glitter::BlendMode blendMode;
+		bool mesh;
+	};
+
 	size_t numVertices;
 	size_t numIndices;
 	size_t numQuads;
-	VertexBuffer* bufferBase;
-	VertexBuffer* bufferCurrent;
+	size_t numCulled;
+	size_t numDrawCalls;
+	uint32_t drawLayer;
+	int lastOrderClass;
+	size_t uploadSize;
+	double fillTime;
+	ParticleVertex* bufferBase;
+	ParticleVertex* bufferCurrent;
 	VertexBuffer* gridBuffer;
-	unsigned int vao, vbo, ebo, gVao, gVbo;
+	QuadInstance* instanceCurrent;
+	unsigned int vao, vbo, ebo, gVao, gVbo, iVao, iVbo, qVbo, mVbo, frameUbo;
 	int texID;
+	unsigned int batchSampler;
+	std::array<unsigned int, 3> samplers;
 	bool batchStarted;
+	bool instancing;
+	bool batchLayered;
+	bool sorting;
+	bool depthSorting;
+	DirectX::XMVECTOR depthAxis;
+	DepthSorter depthSorter;
+	std::vector<float> sortDepths;
+	std::vector<QuadInstance> sortedInstances;
+	std::vector<ParticleVertex> sortedVertices;
 
-	std::shared_ptr<Shader> billboardShader;
-	std::shared_ptr<Shader> meshParticleShader;
-	std::shared_ptr<Shader> gridShader;
-	std::shared_ptr<Shader> meshShader;
+	ShaderBinding billboardShader;
+	ShaderBinding meshParticleShader;
+	ShaderBinding gridShader;
+	ShaderBinding meshShader;
 
-	VertexBuffer buffer[maxVertices];
+	ParticleVertex buffer[maxVertices];
+	QuadInstance instances[maxQuads];
+	std::vector<InstanceData> meshInstances;
+	std::vector<DrawItem> drawList;
 	std::array<unsigned int, maxIndices> indices;
 	std::array<DirectX::XMVECTOR, 4> vPos;
-	std::vector<std::array<DirectX::XMVECTOR, 4>> uvCoords;
-	std::shared_ptr<Shader> shader;
+	const std::vector<Glitter::Editor::UVFrame>* uvFrames;
+	ShaderBinding* shader;
 
 	Glitter::BlendMode blendMode;
 
 	void initQuad();
+	void initInstancedQuad();
 	void initGrid();
+	void initSamplers();
 	void resetVPos();
 	void drawPoolQuad(Glitter::Editor::ParticleInstance& instance, const Camera &camera);
 	void drawPoolMesh(Glitter::Editor::ParticleInstance& instance, const Camera &camera);
-	void getUVCoords(std::shared_ptr<Glitter::Editor::MaterialNode> mat);
+	void collectEmitter(Glitter::Editor::EmitterNode* em);
+	void submitDrawList(const Camera &camera);
+	const Glitter::Editor::UVFrame& getUVFrame(unsigned int index) const;
+	unsigned int getBatchTexture(const TextureData& tex) const;
+	unsigned int getSampler(Glitter::AddressMode mode) const;
+	float getViewDepth(const DirectX::XMFLOAT3& position) const;
 
 public:
 	Renderer();
 	~Renderer();
 
-	void bindShader(std::shared_ptr<Shader>& shader);
-	void configureShader(std::shared_ptr<Shader>& shader, const Glitter::Editor::Viewport &vp, Glitter::BlendMode blend);
+	void bindShader(ShaderBinding& shader);
+	void configureShader(ShaderBinding& shader, Glitter::BlendMode blend);
+	void beginFrame(const Glitter::Editor::Viewport &vp);
 	void setBlendMode(Glitter::BlendMode mode);
 	void beginBatch();
 	void drawGrid(const Glitter::Editor::Viewport &vp);
 	void drawEffect(Glitter::Editor::EffectNode* eff, const Glitter::Editor::Viewport &vp);
 	void drawQuad(const DirectX::XMMATRIX& m4, const Glitter::Color &color, unsigned int uvIndex,
-		const Glitter::Vector2 &uvS, std::shared_ptr<TextureData> tex);
+		const Glitter::Vector2 &uvS, std::shared_ptr<TextureData> tex, unsigned int sampler);
 
-	void drawLocus(const Glitter::Editor::ParticleStatus& p, std::shared_ptr<TextureData> tex);
+	void drawLocus(const Glitter::Editor::ParticleStatus& p, std::shared_ptr<TextureData> tex, unsigned int sampler);
 
 	void flush();
 	void endBatch();
+	void setInstancing(bool enabled);
 
 	inline int getNumVertices() const { return numIndices; }
 	inline int getNumQuads() const { return numQuads; }
+	inline int getNumCulled() const { return numCulled; }
+	inline size_t getUploadSize() const { return uploadSize; }
+	inline double getFillTime() const { return fillTime; }
+	inline bool isInstancing() const { return instancing; }
+	inline bool isSorting() const { return sorting; }
+	inline void setSorting(bool enabled) { sorting = enabled; }
+	inline int getNumDrawCalls() const { return numDrawCalls; }
+	inline bool isDepthSorting() const { return depthSorting; }
+	inline void setDepthSorting(bool enabled) { depthSorting = enabled; }
+	inline DepthSorter& getDepthSorter() { return depthSorter; }
 };
@@ -2,6 +2,7 @@
 
 in vec2 uv1;
 in vec4 color;
+flat in float layer;
 
 out vec4 fragColor;
 
@@ -13,11 +14,13 @@ struct Material
 };
 
 uniform Material material;
+uniform sampler2DArray diffuseArray;
+uniform bool layered;
 uniform int blendMode;
 
 void main()
 {
-    vec4 texColor = texture(material.diffuse0, uv1) * color;
+    vec4 texColor = (layered ? texture(diffuseArray, vec3(uv1, layer)) : texture(material.diffuse0, uv1)) * color;
     if (blendMode == 5 && texColor.a < 0.5)
         discard;
 
@@ -4,15 +4,43 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec4 aColor;
 layout (location = 2) in vec2 aUV1;
 
+// per instance attributes, only read when drawing instanced quads
+layout (location = 3) in vec3 iCenter;
+layout (location = 4) in vec3 iAxisX;
+layout (location = 5) in vec3 iAxisY;
+layout (location = 6) in vec4 iColor;
+layout (location = 7) in vec4 iUVRect;
+layout (location = 8) in float iLayer;
+
 out vec2 uv1;
 out vec4 color;
+flat out float layer;
 
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    vec4 viewDirection;
+};
+uniform bool instanced;
 
 void main()
 {
-    uv1         = aUV1;
-    color       = aColor;
-    gl_Position = projection * view * vec4(aPos, 1.0);
-}
\ No newline at end of file
+    if (instanced)
+    {
+        // aPos is a corner of the unit quad. uv rect is (left, top, right, bottom)
+        vec3 pos    = iCenter + (iAxisX * aPos.x) + (iAxisY * aPos.y);
+        uv1         = vec2(mix(iUVRect.z, iUVRect.x, aPos.x + 0.5), mix(iUVRect.w, iUVRect.y, aPos.y + 0.5));
+        color       = iColor;
+        layer       = iLayer;
+        gl_Position = projection * view * vec4(pos, 1.0);
+    }
+    else
+    {
+        uv1         = aUV1;
+        color       = aColor;
+        layer       = 0.0;
+        gl_Position = projection * view * vec4(aPos, 1.0);
+    }
+}
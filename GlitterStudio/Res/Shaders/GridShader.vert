@@ -5,8 +5,13 @@ layout (location = 1) in vec4 aColor;
 
 out vec4 color;
 
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    vec4 viewDirection;
+};
 
 void main()
 {
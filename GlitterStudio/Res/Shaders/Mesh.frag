@@ -51,7 +51,13 @@ struct Light
 
 uniform Material material;
 uniform Light light;
-uniform vec3 viewPos;
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    vec4 viewDirection;
+};
 uniform int blendMode;
 
 vec2 getUVIndex(int index)
@@ -123,7 +129,7 @@ vec4 calcDiffuse()
     vec4 diffuse = diff * vec4(light.color * material.diffuse.rgb, 1.0) * texture(material.diffuse0, diffUV + diffUVOffset);
 
     // gloss
-    vec3 viewDir = normalize(viewPos - fragPos);
+    vec3 viewDir = normalize(cameraPosition.xyz - fragPos);
     vec3 halfwayDir = normalize(lightDir + viewDir);
 
     float spec = 0.0;
@@ -20,8 +20,13 @@ out vec4 vColor;
 out mat3 tbn;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    vec4 viewDirection;
+};
 
 mat3 createTBN()
 {
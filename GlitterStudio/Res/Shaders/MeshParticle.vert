@@ -4,16 +4,25 @@ layout (location = 0) in vec3 aPos;
 layout (location = 4) in vec4 aColor;
 layout (location = 5) in vec2 aUV;
 
+// per particle attributes
+layout (location = 9) in mat4 iModel;
+layout (location = 13) in vec4 iColor;
+layout (location = 14) in vec2 iUVOffset;
+
 out vec2 uv;
 out vec4 vColor;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    vec4 viewDirection;
+};
 
 void main()
 {
-    uv          = aUV;
-    vColor      = aColor;
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-}
\ No newline at end of file
+    uv          = aUV + iUVOffset;
+    vColor      = aColor * iColor;
+    gl_Position = projection * view * iModel * vec4(aPos, 1.0);
+}
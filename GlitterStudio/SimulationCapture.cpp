@@ -0,0 +1,514 @@
+#include "SimulationCapture.h"
+#include "Logger.h"
+#include <algorithm>
+
+namespace Glitter
+{
+	namespace Editor
+	{
+		constexpr uint32_t captureVersion = 3;
+
+		// about a millimetre for translations and locus points, and a fraction of a percent of scale for the basis and uv scroll
+		constexpr float captureTranslationStep = 1.0f / 1024.0f;
+		constexpr float captureBasisStep = 1.0f / 4096.0f;
+		constexpr float captureQuantizeLimit = (float)(1 << 30);
+
+		static void getInstances(EmitterNode* emitter, std::vector<ParticleInstance*>& instances)
+		{
+			for (auto& instance : emitter->getParticles())
+			{
+				instances.push_back(&instance);
+
+				// every pooled child emitter is included, spawned or not, so the layout stays the same between frames
+				for (auto& childPool : instance.getChildEmitters())
+				{
+					for (auto& child : childPool.instances)
+						getInstances(child.node.get(), instances);
+				}
+			}
+		}
+
+		static std::vector<ParticleInstance*> getInstances(EffectNode* effect)
+		{
+			// child emitter pools are normally allocated on the effect's first update
+			effect->verifyChildEmitters();
+
+			std::vector<ParticleInstance*> instances;
+			for (auto& emitter : effect->getEmitterNodes())
+				getInstances(emitter.get(), instances);
+
+			return instances;
+		}
+
+		// child emitters are drawn while they hold a captured particle, the same way the simulation keeps them active
+		static bool activateChildEmitters(EmitterNode* emitter)
+		{
+			bool alive = false;
+			emitter->setCulled(false);
+
+			for (auto& instance : emitter->getParticles())
+			{
+				for (const ParticleStatus& p : instance.getPool())
+					alive |= !p.dead;
+
+				for (auto& childPool : instance.getChildEmitters())
+				{
+					childPool.activeCount = 0;
+					for (auto& child : childPool.instances)
+					{
+						child.active = activateChildEmitters(child.node.get());
+						childPool.activeCount += child.active;
+					}
+
+					alive |= childPool.activeCount != 0;
+				}
+			}
+
+			return alive;
+		}
+
+		static uint8_t toColorChar(float value)
+		{
+			return (uint8_t)(std::clamp(value, 0.0f, 1.0f) * COLOR_CHAR + 0.5f);
+		}
+
+		static int32_t quantize(float value, float step)
+		{
+			return (int32_t)std::round(std::clamp(value / step, -captureQuantizeLimit, captureQuantizeLimit));
+		}
+
+		static void writeVarint(BinaryWriter* writer, uint32_t value)
+		{
+			while (value >= 0x80)
+			{
+				writer->writeChar((uint8_t)(value | 0x80));
+				value >>= 7;
+			}
+
+			writer->writeChar((uint8_t)value);
+		}
+
+		static uint32_t readVarint(BinaryReader* reader)
+		{
+			uint32_t value = 0;
+			for (int shift = 0; shift < 35; shift += 7)
+			{
+				uint8_t byte = reader->readChar();
+				value |= (uint32_t)(byte & 0x7F) << shift;
+				if (!(byte & 0x80))
+					break;
+			}
+
+			return value;
+		}
+
+		// quantized values are limited to 2^30, so their differences fit
+		static void writeDelta(BinaryWriter* writer, int32_t value, int32_t previous)
+		{
+			int32_t delta = value - previous;
+			writeVarint(writer, ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+		}
+
+		static int32_t readDelta(BinaryReader* reader, int32_t previous)
+		{
+			uint32_t zigzag = readVarint(reader);
+			return previous + (int32_t)((zigzag >> 1) ^ (0 - (zigzag & 1)));
+		}
+
+		static float getComponentStep(size_t component, float translationStep, float basisStep)
+		{
+			return component >= 9 ? translationStep : basisStep;
+		}
+
+		static CapturedParticle captureParticle(const ParticleStatus& p)
+		{
+			CapturedParticle c;
+			c.alive = !p.dead;
+			if (!c.alive)
+				return c;
+
+			for (size_t n = 0; n < 12; ++n)
+				c.transform[n] = quantize(p.mat4.r[n / 3].m128_f32[n % 3], getComponentStep(n, captureTranslationStep, captureBasisStep));
+
+			c.color = Color8(toColorChar(p.color.r), toColorChar(p.color.g), toColorChar(p.color.b), toColorChar(p.color.a));
+			c.uvIndex = (uint16_t)std::max(p.UVIndex, 0);
+			c.uvScroll[0] = quantize(p.uvScroll.x, captureBasisStep);
+			c.uvScroll[1] = quantize(p.uvScroll.y, captureBasisStep);
+
+			c.locus.reserve(p.locusHistories.size() * 3);
+			for (const LocusHistory& history : p.locusHistories)
+			{
+				c.locus.push_back(quantize(history.pos.x, captureTranslationStep));
+				c.locus.push_back(quantize(history.pos.y, captureTranslationStep));
+				c.locus.push_back(quantize(history.pos.z, captureTranslationStep));
+			}
+
+			return c;
+		}
+
+		CaptureRecorder::CaptureRecorder(const std::string& filepath, EffectNode* effect) :
+			frameCountAddress{ 0 }, frameCount{ 0 }
+		{
+			writer = std::make_unique<BinaryWriter>(filepath, Endianness::LITTLE);
+			if (!writer->valid())
+			{
+				Logger::log(Message(MessageType::Error, "Failed to create capture file " + filepath));
+				writer.reset();
+				return;
+			}
+
+			std::vector<ParticleInstance*> instances = getInstances(effect);
+
+			writer->writeString("GCAP", false);
+			writer->writeInt32(captureVersion);
+			writer->writeSingle(captureTranslationStep);
+			writer->writeSingle(captureBasisStep);
+			writer->writeInt32(instances.size());
+
+			size_t slotCount = 0;
+			for (ParticleInstance* instance : instances)
+			{
+				slotCount += instance->getPool().size();
+				writer->writeInt32(instance->getPool().size());
+			}
+
+			previous.resize(slotCount);
+
+			// patched with the final count once recording stops
+			frameCountAddress = writer->getCurrentAddress();
+			writer->writeInt32(0);
+		}
+
+		CaptureRecorder::~CaptureRecorder()
+		{
+			if (writer)
+			{
+				writer->gotoAddress(frameCountAddress);
+				writer->writeInt32(frameCount);
+			}
+		}
+
+		void CaptureRecorder::recordFrame(float time, EffectNode* effect)
+		{
+			if (!writer)
+				return;
+
+			std::vector<ParticleInstance*> instances = getInstances(effect);
+			size_t slotCount = 0;
+			for (ParticleInstance* instance : instances)
+				slotCount += instance->getPool().size();
+
+			if (slotCount != previous.size())
+				return;
+
+			struct Record
+			{
+				uint32_t slot;
+				uint8_t mask;
+				uint16_t components;
+				CapturedParticle last;
+			};
+
+			std::vector<Record> records;
+			size_t slot = 0;
+			for (ParticleInstance* instance : instances)
+			{
+				for (const ParticleStatus& p : instance->getPool())
+				{
+					CapturedParticle current = captureParticle(p);
+					CapturedParticle& last = previous[slot];
+
+					uint8_t mask = 0;
+					uint16_t components = 0;
+					if (current.alive != last.alive)
+						mask |= CaptureAlive;
+
+					if (current.alive)
+					{
+						for (size_t n = 0; n < 12; ++n)
+						{
+							if (current.transform[n] != last.transform[n])
+								components |= 1 << n;
+						}
+
+						if (components)
+							mask |= CaptureTransform;
+
+						if (memcmp(&current.color, &last.color, sizeof(Color8)))
+							mask |= CaptureColor;
+
+						if (current.uvIndex != last.uvIndex)
+							mask |= CaptureUVIndex;
+
+						if (current.uvScroll[0] != last.uvScroll[0] || current.uvScroll[1] != last.uvScroll[1])
+							mask |= CaptureUVScroll;
+
+						if (current.locus != last.locus)
+							mask |= CaptureLocus;
+					}
+
+					if (mask)
+					{
+						// the deltas are written against the state the player still holds
+						records.push_back(Record{ (uint32_t)slot, mask, components, last });
+
+						// dead particles keep their last state so it matches what the player holds
+						if (current.alive)
+							last = std::move(current);
+						else
+							last.alive = false;
+					}
+
+					++slot;
+				}
+			}
+
+			writer->writeSingle(time);
+			writeVarint(writer.get(), records.size());
+
+			uint32_t nextSlot = 0;
+			for (const Record& record : records)
+			{
+				const CapturedParticle& c = previous[record.slot];
+				const CapturedParticle& last = record.last;
+
+				writeVarint(writer.get(), record.slot - nextSlot);
+				writer->writeChar(record.mask);
+				nextSlot = record.slot + 1;
+
+				if (record.mask & CaptureTransform)
+				{
+					writer->writeInt16(record.components);
+					for (size_t n = 0; n < 12; ++n)
+					{
+						if (record.components & (1 << n))
+							writeDelta(writer.get(), c.transform[n], last.transform[n]);
+					}
+				}
+
+				if (record.mask & CaptureColor)
+				{
+					writer->writeChar(c.color.r);
+					writer->writeChar(c.color.g);
+					writer->writeChar(c.color.b);
+					writer->writeChar(c.color.a);
+				}
+
+				if (record.mask & CaptureUVIndex)
+					writeVarint(writer.get(), c.uvIndex);
+
+				if (record.mask & CaptureUVScroll)
+				{
+					writeDelta(writer.get(), c.uvScroll[0], last.uvScroll[0]);
+					writeDelta(writer.get(), c.uvScroll[1], last.uvScroll[1]);
+				}
+
+				if (record.mask & CaptureLocus)
+				{
+					// neighbouring history points are close together, and the newest one is close to the particle
+					writeVarint(writer.get(), c.locus.size() / 3);
+					for (size_t n = 0; n < c.locus.size(); ++n)
+						writeDelta(writer.get(), c.locus[n], n < 3 ? c.transform[9 + n] : c.locus[n - 3]);
+				}
+			}
+
+			++frameCount;
+		}
+
+		bool CaptureRecorder::valid() const
+		{
+			return writer != nullptr;
+		}
+
+		size_t CaptureRecorder::getFrameCount() const
+		{
+			return frameCount;
+		}
+
+		CapturePlayer::CapturePlayer(const std::string& filepath, EffectNode* effect) :
+			firstFrameAddress{ 0 }, frameCount{ 0 }, currentFrame{ 0 }, frameTime{ 0.0f }, translationStep{ 0.0f }, basisStep{ 0.0f }
+		{
+			reader = std::make_unique<BinaryReader>(filepath, Endianness::LITTLE);
+			if (!reader->valid() || reader->readString(4) != "GCAP" || reader->readInt32() != captureVersion)
+			{
+				Logger::log(Message(MessageType::Error, "Failed to open capture file " + filepath));
+				reader.reset();
+				return;
+			}
+
+			translationStep = reader->readSingle();
+			basisStep = reader->readSingle();
+
+			// captures can only be replayed on the effect layout they were recorded from
+			std::vector<ParticleInstance*> instances = getInstances(effect);
+			size_t instanceCount = reader->readInt32();
+			bool match = instanceCount == instances.size();
+
+			size_t slotCount = 0;
+			poolSizes.resize(instanceCount);
+			for (size_t i = 0; i < instanceCount; ++i)
+			{
+				poolSizes[i] = reader->readInt32();
+				slotCount += poolSizes[i];
+
+				if (match && instances[i]->getPool().size() != poolSizes[i])
+					match = false;
+			}
+
+			if (!match)
+			{
+				Logger::log(Message(MessageType::Error, "Capture " + filepath + " was recorded from a different effect."));
+				reader.reset();
+				return;
+			}
+
+			state.resize(slotCount);
+			frameCount = reader->readInt32();
+			firstFrameAddress = reader->getCurrentAddress();
+		}
+
+		bool CapturePlayer::nextFrame(EffectNode* effect)
+		{
+			if (!reader || currentFrame >= frameCount)
+				return false;
+
+			frameTime = reader->readSingle();
+			size_t recordCount = readVarint(reader.get());
+
+			size_t slot = 0;
+			for (size_t r = 0; r < recordCount; ++r)
+			{
+				slot += readVarint(reader.get());
+				uint8_t mask = reader->readChar();
+
+				if (slot >= state.size())
+				{
+					Logger::log(Message(MessageType::Error, "Capture data is corrupted."));
+					reader.reset();
+					return false;
+				}
+
+				CapturedParticle& c = state[slot++];
+				if (mask & CaptureAlive)
+					c.alive ^= true;
+
+				if (mask & CaptureTransform)
+				{
+					uint16_t components = reader->readInt16();
+					for (size_t n = 0; n < 12; ++n)
+					{
+						if (components & (1 << n))
+							c.transform[n] = readDelta(reader.get(), c.transform[n]);
+					}
+				}
+
+				if (mask & CaptureColor)
+				{
+					c.color.r = reader->readChar();
+					c.color.g = reader->readChar();
+					c.color.b = reader->readChar();
+					c.color.a = reader->readChar();
+				}
+
+				if (mask & CaptureUVIndex)
+					c.uvIndex = readVarint(reader.get());
+
+				if (mask & CaptureUVScroll)
+				{
+					c.uvScroll[0] = readDelta(reader.get(), c.uvScroll[0]);
+					c.uvScroll[1] = readDelta(reader.get(), c.uvScroll[1]);
+				}
+
+				if (mask & CaptureLocus)
+				{
+					c.locus.resize(readVarint(reader.get()) * 3);
+					for (size_t n = 0; n < c.locus.size(); ++n)
+						c.locus[n] = readDelta(reader.get(), n < 3 ? c.transform[9 + n] : c.locus[n - 3]);
+				}
+			}
+
+			// feed the captured state straight into the pools the renderer draws from
+			std::vector<ParticleInstance*> instances = getInstances(effect);
+			size_t first = 0;
+			for (size_t i = 0; i < instances.size() && i < poolSizes.size(); ++i)
+			{
+				std::vector<ParticleStatus>& pool = instances[i]->getPool();
+				size_t count = std::min(pool.size(), poolSizes[i]);
+
+				for (size_t n = 0; n < count; ++n)
+				{
+					const CapturedParticle& c = state[first + n];
+					ParticleStatus& p = pool[n];
+
+					p.dead = !c.alive;
+					p.locusHistories.clear();
+					if (p.dead)
+						continue;
+
+					for (size_t row = 0; row < 4; ++row)
+					{
+						float step = getComponentStep(row * 3, translationStep, basisStep);
+						p.mat4.r[row] = DirectX::XMVECTOR{ c.transform[row * 3 + 0] * step, c.transform[row * 3 + 1] * step,
+							c.transform[row * 3 + 2] * step, row == 3 ? 1.0f : 0.0f };
+					}
+
+					p.color = Color((unsigned char*)&c.color);
+					p.UVIndex = c.uvIndex;
+					p.uvScroll = Vector2(c.uvScroll[0] * basisStep, c.uvScroll[1] * basisStep);
+
+					LocusHistory history;
+					history.scale = p.scale;
+					history.color = p.color;
+					for (size_t point = 0; point + 2 < c.locus.size(); point += 3)
+					{
+						history.pos = Vector3(c.locus[point] * translationStep, c.locus[point + 1] * translationStep, c.locus[point + 2] * translationStep);
+						p.locusHistories.push_back(history);
+					}
+				}
+
+				instances[i]->setCulled(false);
+				first += poolSizes[i];
+			}
+
+			for (auto& emitter : effect->getEmitterNodes())
+			{
+				if (!emitter->isChildEmitter())
+					activateChildEmitters(emitter.get());
+			}
+
+			++currentFrame;
+			return true;
+		}
+
+		void CapturePlayer::rewind()
+		{
+			if (!reader)
+				return;
+
+			reader->gotoAddress(firstFrameAddress);
+			currentFrame = 0;
+
+			std::fill(state.begin(), state.end(), CapturedParticle());
+		}
+
+		bool CapturePlayer::valid() const
+		{
+			return reader != nullptr;
+		}
+
+		size_t CapturePlayer::getFrameCount() const
+		{
+			return frameCount;
+		}
+
+		size_t CapturePlayer::getCurrentFrame() const
+		{
+			return currentFrame;
+		}
+
+		float CapturePlayer::getTime() const
+		{
+			return frameTime;
+		}
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "EffectNode.h"
+#include "BinaryWriter.h"
+#include "BinaryReader.h"
+
+namespace Glitter
+{
+	namespace Editor
+	{
+		enum CaptureField : uint8_t
+		{
+			CaptureAlive		= 1 << 0,
+			CaptureTransform	= 1 << 1,
+			CaptureColor		= 1 << 2,
+			CaptureUVIndex		= 1 << 3,
+			CaptureUVScroll		= 1 << 4,
+			CaptureLocus		= 1 << 5
+		};
+
+		// the state the renderer needs to draw a particle without simulating it, quantized to the capture's steps
+		struct CapturedParticle
+		{
+			// basis rows first, translation last
+			int32_t transform[12];
+			Color8 color;
+			uint16_t uvIndex;
+			int32_t uvScroll[2];
+
+			// locus history positions, three per point
+			std::vector<int32_t> locus;
+			bool alive;
+
+			CapturedParticle() : transform{}, uvIndex{ 0 }, uvScroll{}, alive{ false }
+			{
+			}
+		};
+
+		/*
+			Capture file layout (little endian, varints are 7 bits per byte, signed deltas are zigzag encoded):
+				header: "GCAP", version, translation step, basis step, instance count (child emitter pools included),
+						pool size per instance, frame count
+				frame:  time, record count (varint), records
+				record: slots skipped since the previous record (varint), field mask (u8), then each field in the mask:
+					transform:	component mask (u16), then a delta against the previous frame for each changed component
+					color:		rgba bytes
+					uv index:	varint
+					uv scroll:	two deltas
+					locus:		point count (varint), then each point as an xyz delta to the one before it,
+								the first one relative to the particle's translation
+
+			Slots are numbered across all instances in order. Records are only written for slots that changed
+			since the previous frame, and a dead slot keeps its last state to delta against once it respawns.
+		*/
+		class CaptureRecorder
+		{
+		private:
+			std::unique_ptr<BinaryWriter> writer;
+			std::vector<CapturedParticle> previous;
+			size_t frameCountAddress;
+			size_t frameCount;
+
+		public:
+			CaptureRecorder(const std::string& filepath, EffectNode* effect);
+			~CaptureRecorder();
+
+			void recordFrame(float time, EffectNode* effect);
+			bool valid() const;
+			size_t getFrameCount() const;
+		};
+
+		class CapturePlayer
+		{
+		private:
+			std::unique_ptr<BinaryReader> reader;
+			std::vector<CapturedParticle> state;
+			std::vector<size_t> poolSizes;
+			float translationStep;
+			float basisStep;
+			size_t firstFrameAddress;
+			size_t frameCount;
+			size_t currentFrame;
+			float frameTime;
+
+		public:
+			CapturePlayer(const std::string& filepath, EffectNode* effect);
+
+			bool nextFrame(EffectNode* effect);
+			void rewind();
+			bool valid() const;
+			size_t getFrameCount() const;
+			size_t getCurrentFrame() const;
+			float getTime() const;
+		};
+	}
+}
@@ -0,0 +1,86 @@
+#include "SimulationCheckpoint.h"
+#include "CommandManager.h"
+#include "Utilities.h"
+
+namespace Glitter
+{
+	namespace Editor
+	{
+		CheckpointManager::CheckpointManager() :
+			effect{ nullptr }, revision{ 0 }, interval{ 60.0f }, maxCount{ 64 }
+		{
+		}
+
+		void CheckpointManager::validate(EffectNode* eff)
+		{
+			// any edit can change how the effect plays out
+			if (eff != effect || revision != CommandManager::getRevision())
+			{
+				checkpoints.clear();
+				effect = eff;
+				revision = CommandManager::getRevision();
+			}
+		}
+
+		void CheckpointManager::update(float time, EffectNode* eff)
+		{
+			validate(eff);
+
+			if (checkpoints.size() >= maxCount)
+				return;
+
+			if (checkpoints.size() && time < checkpoints.back().time + interval)
+				return;
+
+			// the first checkpoint is always taken at the start of playback
+			if (checkpoints.empty() && time > 0.0f)
+				return;
+
+			SimulationCheckpoint checkpoint;
+			checkpoint.time = time;
+			checkpoint.effect = eff->saveState();
+			checkpoint.random = Utilities::getRandomState();
+			checkpoints.emplace_back(std::move(checkpoint));
+		}
+
+		float CheckpointManager::restore(float time, EffectNode* eff)
+		{
+			validate(eff);
+
+			for (auto it = checkpoints.rbegin(); it != checkpoints.rend(); ++it)
+			{
+				if (it->time > time)
+					continue;
+
+				if (!eff->restoreState(it->effect))
+					break;
+
+				Utilities::setRandomState(it->random);
+				return it->time;
+			}
+
+			return -1.0f;
+		}
+
+		void CheckpointManager::clear()
+		{
+			checkpoints.clear();
+		}
+
+		void CheckpointManager::setInterval(float val)
+		{
+			interval = val;
+			checkpoints.clear();
+		}
+
+		float CheckpointManager::getInterval() const
+		{
+			return interval;
+		}
+
+		size_t CheckpointManager::getCount() const
+		{
+			return checkpoints.size();
+		}
+	}
+}
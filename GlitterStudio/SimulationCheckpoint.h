@@ -0,0 +1,42 @@
+#pragma once
+#include "EffectNode.h"
+#include <random>
+
+namespace Glitter
+{
+	namespace Editor
+	{
+		struct SimulationCheckpoint
+		{
+			float time;
+			EffectState effect;
+			std::mt19937 random;
+		};
+
+		/// <summary>
+		/// Takes snapshots of the previewed effect at regular intervals so playback can seek or loop
+		/// by restoring the nearest snapshot instead of simulating from the start.
+		/// </summary>
+		class CheckpointManager
+		{
+		private:
+			std::vector<SimulationCheckpoint> checkpoints;
+			EffectNode* effect;
+			size_t revision;
+			float interval;
+			size_t maxCount;
+
+			void validate(EffectNode* eff);
+
+		public:
+			CheckpointManager();
+
+			void update(float time, EffectNode* eff);
+			float restore(float time, EffectNode* eff);
+			void clear();
+			void setInterval(float val);
+			float getInterval() const;
+			size_t getCount() const;
+		};
+	}
+}
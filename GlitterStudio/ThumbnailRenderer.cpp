@@ -0,0 +1,388 @@
+#include "ThumbnailRenderer.h"
+#include "Application.h"
+#include "ResourceManager.h"
+#include "Renderer.h"
+#include "ParticleCulling.h"
+#include "ParticleBudget.h"
+#include "Utilities.h"
+#include "File.h"
+#include "stb_image_write.h"
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <stdio.h>
+
+#define NOMINMAX
+#include <Windows.h>
+
+namespace Glitter
+{
+	namespace Editor
+	{
+		bool ThumbnailRenderer::isRequested(int argc, char* argv[])
+		{
+			return argc > 1 && std::strcmp(argv[1], "--thumbnails") == 0;
+		}
+
+		void ThumbnailRenderer::printUsage()
+		{
+			printf("usage: GlitterStudio --thumbnails <effect or directory> <output directory> [options]\n"
+				"  --size <w> <h>        thumbnail size in pixels (256 256)\n"
+				"  --frames <n>          frames per strip, laid out left to right (1)\n"
+				"  --time <t>            time of the first frame in frames (60)\n"
+				"  --step <t>            time between strip frames (15)\n"
+				"  --camera <yaw> <pitch> <distance>\n"
+				"  --grid                draw the ground grid\n"
+				"  --jobs <n>            split a directory across n processes (1)\n"
+				"  --software            create an OSMesa context instead of a native one\n");
+		}
+
+		bool ThumbnailRenderer::parseArguments(int argc, char* argv[], ThumbnailOptions& options)
+		{
+			if (argc < 4)
+				return false;
+
+			options.input = argv[2];
+			options.output = argv[3];
+
+			for (int i = 4; i < argc; ++i)
+			{
+				std::string arg = argv[i];
+				int remaining = argc - i - 1;
+
+				if (arg == "--size" && remaining >= 2)
+				{
+					options.width = std::max(1, std::atoi(argv[++i]));
+					options.height = std::max(1, std::atoi(argv[++i]));
+				}
+				else if (arg == "--frames" && remaining >= 1)
+					options.frames = std::max(1, std::atoi(argv[++i]));
+				else if (arg == "--time" && remaining >= 1)
+					options.startTime = std::max(0.0f, (float)std::atof(argv[++i]));
+				else if (arg == "--step" && remaining >= 1)
+					options.frameStep = std::max(1.0f, (float)std::atof(argv[++i]));
+				else if (arg == "--camera" && remaining >= 3)
+				{
+					options.yaw = std::atof(argv[++i]);
+					options.pitch = std::clamp((float)std::atof(argv[++i]), -89.0f, 89.0f);
+					options.distance = std::atof(argv[++i]);
+				}
+				else if (arg == "--jobs" && remaining >= 1)
+					options.jobs = std::max(1, std::atoi(argv[++i]));
+				else if (arg == "--shard" && remaining >= 2)
+				{
+					options.shard = std::atoi(argv[++i]);
+					options.shardCount = std::max(1, std::atoi(argv[++i]));
+				}
+				else if (arg == "--grid")
+					options.grid = true;
+				else if (arg == "--software")
+					options.software = true;
+				else
+				{
+					printf("Unknown or incomplete option %s\n", arg.c_str());
+					return false;
+				}
+			}
+
+			return options.shard >= 0 && options.shard < options.shardCount;
+		}
+
+		std::vector<std::string> ThumbnailRenderer::collectEffects(const ThumbnailOptions& options)
+		{
+			std::vector<std::string> files;
+			if (std::filesystem::is_directory(options.input))
+			{
+				for (const auto& file : std::filesystem::directory_iterator(options.input))
+				{
+					std::string extension = file.path().extension().string();
+					std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+					if (extension == ".gte")
+						files.emplace_back(file.path().string());
+				}
+
+				// every shard has to see the same order to split the list consistently
+				std::sort(files.begin(), files.end());
+			}
+			else if (File::exists(options.input))
+			{
+				files.emplace_back(options.input);
+			}
+
+			std::vector<std::string> shard;
+			for (size_t i = options.shard; i < files.size(); i += options.shardCount)
+				shard.emplace_back(files[i]);
+
+			return shard;
+		}
+
+		// quotes one argument so the child's CRT splits the command line back into the same argv
+		static std::string quoteArgument(const std::string& arg)
+		{
+			if (arg.size() && arg.find_first_of(" \t\n\v\"") == std::string::npos)
+				return arg;
+
+			std::string quoted = "\"";
+			for (size_t i = 0; ; ++i)
+			{
+				size_t backslashes = 0;
+				while (i < arg.size() && arg[i] == '\\')
+				{
+					++backslashes;
+					++i;
+				}
+
+				// backslashes only escape when they come before a quote, including the closing one
+				if (i == arg.size())
+				{
+					quoted.append(backslashes * 2, '\\');
+					break;
+				}
+
+				if (arg[i] == '"')
+				{
+					quoted.append(backslashes * 2 + 1, '\\');
+					quoted += '"';
+				}
+				else
+				{
+					quoted.append(backslashes, '\\');
+					quoted += arg[i];
+				}
+			}
+
+			return quoted + "\"";
+		}
+
+		int ThumbnailRenderer::launchJobs(int argc, char* argv[], const ThumbnailOptions& options)
+		{
+			// children get the same arguments; later options override earlier ones
+			std::vector<std::vector<std::string>> jobArgs(options.jobs);
+			for (int job = 0; job < options.jobs; ++job)
+			{
+				jobArgs[job].assign(argv, argv + argc);
+				jobArgs[job].insert(jobArgs[job].end(), { "--jobs", "1", "--shard", std::to_string(job), std::to_string(options.jobs) });
+			}
+
+			int failed = 0;
+			char executable[MAX_PATH];
+			GetModuleFileNameA(NULL, executable, MAX_PATH);
+
+			std::vector<PROCESS_INFORMATION> processes;
+			for (int job = 0; job < options.jobs; ++job)
+			{
+				std::string commandLine;
+				for (const std::string& arg : jobArgs[job])
+					commandLine += (commandLine.size() ? " " : "") + quoteArgument(arg);
+
+				// children share this console, so their output shows up here and no window opens
+				STARTUPINFOA startup{};
+				startup.cb = sizeof(startup);
+				PROCESS_INFORMATION process{};
+				if (!CreateProcessA(executable, &commandLine[0], NULL, NULL, FALSE, 0, NULL, NULL, &startup, &process))
+				{
+					printf("Failed to start job %d (error %lu)\n", job, GetLastError());
+					++failed;
+					continue;
+				}
+
+				CloseHandle(process.hThread);
+				processes.emplace_back(process);
+			}
+
+			for (PROCESS_INFORMATION& process : processes)
+			{
+				DWORD exitCode = 1;
+				WaitForSingleObject(process.hProcess, INFINITE);
+				GetExitCodeProcess(process.hProcess, &exitCode);
+				CloseHandle(process.hProcess);
+
+				if (exitCode != 0)
+					++failed;
+			}
+
+			if (failed)
+				printf("%d of %d jobs failed\n", failed, options.jobs);
+
+			return failed ? 1 : 0;
+		}
+
+		std::shared_ptr<EffectNode> ThumbnailRenderer::loadEffect(const std::string& filename, std::vector<std::shared_ptr<MaterialNode>>& materials)
+		{
+			auto effect = std::make_shared<Glitter::GlitterEffect>(filename);
+			auto effectNode = std::make_shared<EffectNode>(effect);
+
+			// same lookup as ParticleEditor::open, but kept out of the editor's material list
+			std::string filepath = File::getFilePath(filename);
+			for (auto& p : effectNode->getParticleNodes())
+			{
+				std::string materialFile = filepath + p->getParticle()->getMaterial() + ".gtm";
+				auto it = std::find_if(materials.begin(), materials.end(),
+					[&materialFile](const std::shared_ptr<MaterialNode>& m) { return m->getMaterial()->getFilename() == materialFile; });
+
+				if (it == materials.end())
+				{
+					if (!File::exists(materialFile))
+						continue;
+
+					auto material = std::make_shared<Glitter::GlitterMaterial>(materialFile);
+					materials.emplace_back(std::make_shared<MaterialNode>(material));
+					it = materials.end() - 1;
+				}
+
+				p->setMaterial(*it);
+			}
+
+			return effectNode;
+		}
+
+		bool ThumbnailRenderer::renderEffect(const std::string& filename, Renderer* renderer, Viewport& viewport,
+			std::vector<std::shared_ptr<MaterialNode>>& materials, const ThumbnailOptions& options)
+		{
+			std::shared_ptr<EffectNode> effect = loadEffect(filename, materials);
+
+			ParticleCulling culling;
+			culling.update(viewport.getCamera(), (float)options.width / options.height);
+
+			size_t frameSize = (size_t)options.width * options.height * 4;
+			size_t rowSize = (size_t)options.width * 4;
+			size_t sheetRowSize = rowSize * options.frames;
+			std::vector<unsigned char> sheet(frameSize * options.frames);
+			std::vector<unsigned char> pixels;
+
+			float time = 0.0f;
+			for (unsigned int frame = 0; frame < options.frames; ++frame)
+			{
+				// simulate up to the frame at preview frame rate, like GlitterPlayer::seek
+				float target = options.startTime + options.frameStep * frame;
+				for (; time <= target; time += 1.0f)
+				{
+					ParticleBudget::beginFrame();
+					effect->update(time, viewport.getCamera(), culling);
+				}
+
+				viewport.useOffscreen(options.width, options.height);
+				renderer->beginFrame(viewport);
+
+				if (options.grid)
+					renderer->drawGrid(viewport);
+
+				renderer->drawEffect(effect.get(), viewport);
+				viewport.endOffscreen();
+
+				if (!viewport.readPixels(pixels))
+					return false;
+
+				for (unsigned int row = 0; row < options.height; ++row)
+					std::memcpy(&sheet[row * sheetRowSize + frame * rowSize], &pixels[row * rowSize], rowSize);
+			}
+
+			std::string outFile = options.output + File::getFileNameWithoutExtension(filename) + ".png";
+			return stbi_write_png(outFile.c_str(), options.width * options.frames, options.height, 4, sheet.data(), 0) != 0;
+		}
+
+		int ThumbnailRenderer::renderShard(const ThumbnailOptions& options)
+		{
+			std::vector<std::string> files = collectEffects(options);
+			if (files.empty())
+				return 0;
+
+			glfwInit();
+			glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+			glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+			glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+			// llvmpipe through OSMesa needs no display or GPU
+			if (options.software)
+				glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+
+			GLFWwindow* window = glfwCreateWindow(options.width, options.height, "Glitter Studio", NULL, NULL);
+			if (window == NULL)
+			{
+				printf("Failed to create an OpenGL context.\n");
+				glfwTerminate();
+				return 1;
+			}
+
+			glfwMakeContextCurrent(window);
+			if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+			{
+				printf("Failed to load OpenGL procedures.\n");
+				glfwTerminate();
+				return 1;
+			}
+
+			glLineWidth(3.0f);
+			glPointSize(3.0f);
+			glEnable(GL_MULTISAMPLE);
+
+			std::string shadersDir = Application::getShadersDirectory();
+			ResourceManager::loadShader("BillboardParticle", shadersDir + "BillboardParticle");
+			ResourceManager::loadShader("MeshParticle", shadersDir + "MeshParticle");
+			ResourceManager::loadShader("Grid", shadersDir + "GridShader");
+			ResourceManager::loadShader("Mesh", shadersDir + "Mesh");
+
+			Utilities::initRandom();
+
+			int failed = 0;
+			{
+				Renderer renderer;
+				Viewport viewport;
+
+				Camera camera;
+				camera.setAngle(options.yaw, options.pitch);
+				if (options.distance > 0.0f)
+					camera.setDistance(options.distance);
+
+				viewport.setCamera(camera);
+
+				// effects in the same folder usually share materials and textures
+				std::vector<std::shared_ptr<MaterialNode>> materials;
+				for (const std::string& file : files)
+				{
+					if (renderEffect(file, &renderer, viewport, materials, options))
+					{
+						printf("%s\n", file.c_str());
+					}
+					else
+					{
+						printf("Failed to render %s\n", file.c_str());
+						++failed;
+					}
+				}
+
+				materials.clear();
+				ResourceManager::disposeAll();
+			}
+
+			glfwDestroyWindow(window);
+			glfwTerminate();
+
+			return failed ? 1 : 0;
+		}
+
+		int ThumbnailRenderer::run(int argc, char* argv[])
+		{
+			ThumbnailOptions options;
+			if (!parseArguments(argc, argv, options))
+			{
+				printUsage();
+				return 1;
+			}
+
+			if (options.output.size() && options.output.back() != '\\' && options.output.back() != '/')
+				options.output += '/';
+
+			if (!std::filesystem::exists(options.output))
+				std::filesystem::create_directories(options.output);
+
+			Application::setDirectory(argv[0]);
+
+			if (options.jobs > 1 && std::filesystem::is_directory(options.input))
+				return launchJobs(argc, argv, options);
+
+			return renderShard(options);
+		}
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "Viewport.h"
+#include "EffectNode.h"
+#include <string>
+#include <vector>
+#include <memory>
+
+class Renderer;
+
+namespace Glitter
+{
+	namespace Editor
+	{
+		struct ThumbnailOptions
+		{
+			std::string input;
+			std::string output;
+			unsigned int width = 256;
+			unsigned int height = 256;
+			unsigned int frames = 1;
+			float startTime = 60.0f;
+			float frameStep = 15.0f;
+			float yaw = -45.0f;
+			float pitch = 20.0f;
+			float distance = 0.0f;
+			int jobs = 1;
+			int shard = 0;
+			int shardCount = 1;
+			bool software = false;
+			bool grid = false;
+		};
+
+		/// <summary>
+		/// Renders effect thumbnails and frame strips from the command line without the editor UI.
+		/// Drawing goes through the regular renderer into an offscreen render target of a hidden window,
+		/// and whole directories can be split across several processes.
+		/// </summary>
+		class ThumbnailRenderer
+		{
+		private:
+			static bool parseArguments(int argc, char* argv[], ThumbnailOptions& options);
+			static std::vector<std::string> collectEffects(const ThumbnailOptions& options);
+			static int launchJobs(int argc, char* argv[], const ThumbnailOptions& options);
+			static int renderShard(const ThumbnailOptions& options);
+			static std::shared_ptr<EffectNode> loadEffect(const std::string& filename, std::vector<std::shared_ptr<MaterialNode>>& materials);
+			static bool renderEffect(const std::string& filename, Renderer* renderer, Viewport& viewport,
+				std::vector<std::shared_ptr<MaterialNode>>& materials, const ThumbnailOptions& options);
+
+		public:
+			static bool isRequested(int argc, char* argv[]);
+			static int run(int argc, char* argv[]);
+			static void printUsage();
+		};
+	}
+}
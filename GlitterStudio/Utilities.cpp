@@ -1,9 +1,21 @@
 #include "Utilities.h"
 #include <ctime>
 
+std::mt19937 Utilities::randomEngine;
+
 void Utilities::initRandom()
 {
-	std::srand(static_cast<unsigned int>(std::time(nullptr)));
+	randomEngine.seed(static_cast<unsigned int>(std::time(nullptr)));
+}
+
+std::mt19937 Utilities::getRandomState()
+{
+	return randomEngine;
+}
+
+void Utilities::setRandomState(const std::mt19937& state)
+{
+	randomEngine = state;
 }
 
 float Utilities::random(float min, float max)
@@ -11,7 +23,7 @@ float Utilities::random(float min, float max)
 	if (min == max)
 		return min;
 
-	return min + static_cast<float>(rand()) / static_cast<float>(RAND_MAX / (max - min));
+	return min + static_cast<float>(randomEngine()) / static_cast<float>(randomEngine.max() / (max - min));
 }
 
 float Utilities::randomize(const float f1, const float f2)
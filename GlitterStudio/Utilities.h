@@ -3,12 +3,18 @@
 #include <ctime>
 #include <memory>
 #include <stdexcept>
+#include <random>
 #include "MathGens.h"
 
 class Utilities
 {
+private:
+	static std::mt19937 randomEngine;
+
 public:
 	static void initRandom();
+	static std::mt19937 getRandomState();
+	static void setRandomState(const std::mt19937& state);
 
 	static float random(float min, float max);
 	static float randomize(const float f1, const float f2);
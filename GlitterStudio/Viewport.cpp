@@ -65,21 +65,48 @@ namespace Glitter
 			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 		}
 
+		void Viewport::useOffscreen(unsigned int width, unsigned int height)
+		{
+			// same as use(), minus imgui layout and camera input
+			size = Glitter::Vector2(width, height);
+
+			fBuffer.resize(width, height);
+			fBuffer.use();
+			fBuffer.clear();
+			glPolygonMode(GL_FRONT_AND_BACK, GL_POINT + drawMode);
+		}
+
+		void Viewport::endOffscreen()
+		{
+			fBuffer.end();
+			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		}
+
+		bool Viewport::readPixels(std::vector<unsigned char>& pixels) const
+		{
+			if (!fBuffer.getWidth() || !fBuffer.getHeight())
+				return false;
+
+			pixels.resize((size_t)fBuffer.getWidth() * fBuffer.getHeight() * 4);
+
+			glPixelStorei(GL_PACK_ALIGNMENT, 1);
+			glBindTexture(GL_TEXTURE_2D, fBuffer.getTexture());
+			glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			return true;
+		}
+
 		void Viewport::saveScreenshot()
 		{
-			unsigned char* data = (unsigned char*)malloc((size_t)(fBuffer.getWidth() * fBuffer.getHeight() * 4));
-			if (data)
+			std::vector<unsigned char> data;
+			if (readPixels(data))
 			{
-				glBindTexture(GL_TEXTURE_2D, fBuffer.getTexture());
-				glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-
 				if (!std::filesystem::exists(Application::getScreenshotsDirectory()))
 					std::filesystem::create_directory(Application::getScreenshotsDirectory());
 
 				std::string filename = Application::getScreenshotsDirectory() + Utilities::getCurrentDateTime() + ".png";
-				stbi_write_png(filename.c_str(), fBuffer.getWidth(), fBuffer.getHeight(), 4, data, 0);
-
-				free(data);
+				stbi_write_png(filename.c_str(), fBuffer.getWidth(), fBuffer.getHeight(), 4, data.data(), 0);
 			}
 		}
 
@@ -259,6 +286,11 @@ namespace Glitter
 			camera.reset();
 		}
 
+		void Viewport::setCamera(const Camera& cam)
+		{
+			camera = cam;
+		}
+
 		void Viewport::toggleLight()
 		{
 			lightEnabled ^= true;
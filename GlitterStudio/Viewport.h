@@ -4,6 +4,7 @@
 #include "RenderTarget.h"
 #include "ImGui/imgui.h"
 #include "ImGui/imgui_internal.h"
+#include <vector>
 
 namespace Glitter
 {
@@ -36,6 +37,10 @@ namespace Glitter
 			void toggleLight();
 			void renderingControl();
 			void screenshotControl();
+			void useOffscreen(unsigned int width, unsigned int height);
+			void endOffscreen();
+			bool readPixels(std::vector<unsigned char>& pixels) const;
+			void setCamera(const Camera& cam);
 
 			Glitter::Vector2 getSize() const;
 			Camera getCamera() const;
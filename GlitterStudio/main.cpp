@@ -2,10 +2,22 @@
 #include <exception>
 #include <filesystem>
 #include "Application.h"
+#include "ThumbnailRenderer.h"
+
+#define NOMINMAX
 #include <Windows.h>
 
 int main(int argc, char* argv[])
 {
+	if (Glitter::Editor::ThumbnailRenderer::isRequested(argc, argv))
+		return Glitter::Editor::ThumbnailRenderer::run(argc, argv);
+
+	// the thumbnail renderer needs the console subsystem to print and return its exit code to the shell.
+	// the editor lets go of the console when nothing else is attached, so launching it from explorer leaves no window behind.
+	DWORD consoleProcesses[2];
+	if (GetConsoleProcessList(consoleProcesses, 2) == 1)
+		FreeConsole();
+
 	try
 	{
 		Glitter::Editor::Application app(argv[0]);
@@ -15,7 +27,7 @@ int main(int argc, char* argv[])
 	{
 		std::string msg("An unhandled exception has occured and the application will now close.\nError. ");
 		msg.append(e.what());
-		MessageBox(NULL, msg.c_str(), "Glitter Studio", MB_OK | MB_ICONERROR);
+		Glitter::Editor::Application::showError(msg);
 	}
 	
 	return 0;